@@ -1,45 +1,65 @@
-QT += core gui widgets
+QT += core gui widgets concurrent
 
 QMAKE_CXXFLAGS += -std=c++2a
 
 DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
+    animationclock.cpp \
     appsettings.cpp \
+    assetindex.cpp \
+    assetmanifest.cpp \
+    assetwatcher.cpp \
+    autosavejournal.cpp \
     charactereditor.cpp \
     eventslist.cpp \
     eventslistfiltermodel.cpp \
     fontdatabase.cpp \
+    framecache.cpp \
     gif.cpp \
     gifslider.cpp \
+    hspreader.cpp \
+    hspwriter.cpp \
     imageslider.cpp \
     main.cpp \
     mainwindow.cpp \
     modsmanager.cpp \
     page.cpp \
     pageelement.cpp \
+    pageloader.cpp \
     pagesettings.cpp \
     tabbedimages.cpp \
     text.cpp \
+    undostack.cpp \
     utils.cpp
 
 HEADERS += \
+    animationclock.h \
     appsettings.h \
+    assetindex.h \
+    assetmanifest.h \
+    assetwatcher.h \
+    autosavejournal.h \
     charactereditor.h \
     eventslist.h \
     eventslistfiltermodel.h \
     fontdatabase.h \
+    framecache.h \
     gif.h \
     gifslider.h \
     globals.h \
+    hspreader.h \
+    hspwriter.h \
     imageslider.h \
     mainwindow.h \
     modsmanager.h \
     page.h \
     pageelement.h \
+    pageloader.h \
     pagesettings.h \
     tabbedimages.h \
     text.h \
+    undostack.h \
     utils.h
 
 FORMS += \
@@ -0,0 +1,132 @@
+#include "animationclock.h"
+#include "pageelement.h"
+#include <QGraphicsItem>
+#include <algorithm>
+
+// don't jump ahead after the event loop has been blocked (dialogs, loading, ...)
+constexpr float MAX_DT = 0.1f;
+
+AnimationClock::AnimationClock()
+{
+    instance = this;
+
+    timerId = startTimer(1000 / 60, Qt::PreciseTimer);
+    elapsed.start();
+}
+
+AnimationClock::~AnimationClock()
+{
+    instance = nullptr;
+}
+
+AnimationClock * AnimationClock::Get()
+{
+    return instance;
+}
+
+void AnimationClock::Register(PageElement * element)
+{
+    if (instance)
+    {
+        instance->elements.append({ element });
+    }
+}
+
+void AnimationClock::Unregister(PageElement * element)
+{
+    if (instance)
+    {
+        auto & elements = instance->elements;
+        auto removed = std::stable_partition(elements.begin(), elements.end(), [element](const Entry & entry) {
+            return entry.element != element;
+        });
+        QVector<QGraphicsItem*> items;
+        for (auto it = removed; it != elements.end(); ++it)
+        {
+            if (it->item)
+            {
+                items.append(it->item);
+            }
+        }
+        elements.erase(removed, elements.end());
+
+        for (auto item : items)
+        {
+            emit instance->unregistered(item);
+        }
+    }
+}
+
+// elements outside of this rect (in scene coordinates) only keep their
+// animations' progress up to date, without rendering anything.
+void AnimationClock::SetVisibleRect(QRectF rect)
+{
+    if (instance)
+    {
+        instance->visibleRect = rect;
+    }
+}
+
+void AnimationClock::SetManual(bool manual)
+{
+    if (!instance || manual == (instance->timerId == 0))
+    {
+        return;
+    }
+
+    if (manual)
+    {
+        instance->killTimer(instance->timerId);
+        instance->timerId = 0;
+    }
+    else
+    {
+        instance->timerId = instance->startTimer(1000 / 60, Qt::PreciseTimer);
+        instance->elapsed.restart();
+    }
+}
+
+void AnimationClock::Step(float dt)
+{
+    if (instance)
+    {
+        instance->tick(dt);
+    }
+}
+
+void AnimationClock::timerEvent(QTimerEvent * event)
+{
+    Q_UNUSED(event)
+
+    tick(std::min(elapsed.restart() / 1000.f, MAX_DT));
+}
+
+void AnimationClock::tick(float dt)
+{
+    changedItems.clear();
+
+    for (int i = 0; i < elements.size(); i++)
+    {
+        auto & entry = elements[i];
+
+        // can't be done in Register(), the QGraphicsItem part doesn't exist yet.
+        if (!entry.item)
+        {
+            entry.item = dynamic_cast<QGraphicsItem*>(entry.element);
+        }
+
+        bool visible = true;
+        if (entry.item && !visibleRect.isNull())
+        {
+            // grown by a pixel, so that items without a pixmap yet still intersect.
+            visible = visibleRect.intersects(entry.item->sceneBoundingRect().adjusted(-1, -1, 1, 1));
+        }
+
+        if (entry.element->animate(dt, visible) && entry.item)
+        {
+            changedItems.append(entry.item);
+        }
+    }
+
+    emit ticked(dt, changedItems);
+}
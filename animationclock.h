@@ -0,0 +1,53 @@
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRectF>
+
+class PageElement;
+class QGraphicsItem;
+class AnimationClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    AnimationClock();
+    ~AnimationClock();
+
+    static AnimationClock * Get();
+    static void Register(PageElement * element);
+    static void Unregister(PageElement * element);
+    static void SetVisibleRect(QRectF rect);
+
+    // stops following the time, the animations only move when stepped:
+    // the same steps always give the same frames.
+    static void SetManual(bool manual);
+    static void Step(float dt);
+
+signals:
+    void ticked(float dt, const QVector<QGraphicsItem*> & changedItems);
+    // the item may already be destroyed, only its address can be used
+    void unregistered(QGraphicsItem * item);
+
+protected:
+    void timerEvent(QTimerEvent * event) override;
+
+private:
+    void tick(float dt);
+
+    static inline AnimationClock * instance = nullptr;
+    struct Entry {
+        PageElement * element = nullptr;
+        QGraphicsItem * item = nullptr;
+    };
+
+    QVector<Entry> elements;
+    QVector<QGraphicsItem*> changedItems;
+    QRectF visibleRect;
+    QElapsedTimer elapsed;
+    int timerId = 0;
+};
+
+#endif // ANIMATIONCLOCK_H
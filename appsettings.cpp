@@ -1,8 +1,11 @@
 #include "appsettings.h"
+#include "assetindex.h"
 #include <QDir>
+#include <QFileInfo>
 
 #define ROOT_PATH "paths/root"
 #define MODS_PATH "config/mods"
+#define UNDO_BUDGET "config/undoBudget"
 
 AppSettings::AppSettings()
     : settings("settings.ini", QSettings::IniFormat)
@@ -60,6 +63,11 @@ QString AppSettings::GetFilePath(QString filename)
 {
     if (filename[0] != '/') filename = "/" + filename;
 
+    if (AssetIndex::Covers(filename))
+    {
+        return AssetIndex::Resolve(filename);
+    }
+
     auto paths = GetSearchPaths();
     for (auto path : paths)
     {
@@ -72,12 +80,54 @@ QString AppSettings::GetFilePath(QString filename)
     return QString();
 }
 
+QString AppSettings::GetSettingsDirectory()
+{
+    return QFileInfo(instance->settings.fileName()).absolutePath();
+}
+
 void AppSettings::SetPageDirty(bool dirty)
 {
+    if (instance->modificationsSuspended) return;
+
     instance->isDirty = dirty;
+    if (dirty)
+    {
+        instance->pageRevision++;
+
+        if (instance->pageModified)
+        {
+            instance->pageModified();
+        }
+    }
 }
 
 bool AppSettings::IsPageDirty()
 {
     return instance->isDirty;
 }
+
+void AppSettings::SuspendPageModifications(bool suspended)
+{
+    instance->modificationsSuspended = suspended;
+}
+
+quint64 AppSettings::GetPageRevision()
+{
+    return instance->pageRevision;
+}
+
+void AppSettings::SetPageModifiedCallback(std::function<void()> callback)
+{
+    instance->pageModified = callback;
+}
+
+void AppSettings::SetUndoBudget(qint64 bytes)
+{
+    instance->settings.setValue(UNDO_BUDGET, bytes);
+    instance->settings.sync();
+}
+
+qint64 AppSettings::GetUndoBudget()
+{
+    return instance->settings.value(UNDO_BUDGET, 16 * 1024 * 1024).toLongLong();
+}
@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QSettings>
+#include <functional>
 
 class AppSettings
 {
@@ -22,13 +23,27 @@ public:
 
     static QString GetFilePath(QString filename);
 
+    static QString GetSettingsDirectory();
+
     static void SetPageDirty(bool dirty = true);
     static bool IsPageDirty();
+    // while suspended, refreshing the elements doesn't modify the page
+    static void SuspendPageModifications(bool suspended);
+    // bumped by every modification of the page
+    static quint64 GetPageRevision();
+    // called by every modification of the page
+    static void SetPageModifiedCallback(std::function<void()> callback);
+
+    static void SetUndoBudget(qint64 bytes);
+    static qint64 GetUndoBudget();
 
 private:
     static inline AppSettings * instance = nullptr;
     QSettings settings;
     bool isDirty = false;
+    bool modificationsSuspended = false;
+    quint64 pageRevision = 0;
+    std::function<void()> pageModified;
 };
 
 #endif // APPSETTINGS_H
@@ -0,0 +1,95 @@
+#include "assetindex.h"
+#include "assetmanifest.h"
+#include <QDir>
+
+// only these trees are indexed, everything else is looked up on disk.
+static const QStringList indexedDirectories = { "images", "misc" };
+
+void AssetIndex::Rebuild(QStringList searchPaths)
+{
+    entries.clear();
+    listings.clear();
+
+    for (int priority = 0; priority < searchPaths.size(); priority++)
+    {
+        auto root = QDir(searchPaths[priority]).absolutePath();
+        QHash<QString, QStringList> rootListings;
+
+        // the listings come from the manifest when the folders haven't changed
+        QStringList pending = indexedDirectories;
+        while (!pending.isEmpty())
+        {
+            auto directory = pending.takeLast();
+            for (auto & dirEntry : AssetManifest::Entries(root + "/" + directory))
+            {
+                auto relativePath = directory + "/" + dirEntry.name;
+                auto key = normalize(relativePath);
+
+                // mods are searched before the game, the first one wins
+                if (!entries.contains(key))
+                {
+                    entries.insert(key, Entry { root + "/" + relativePath, priority, dirEntry.isDir });
+                }
+
+                if (dirEntry.isDir)
+                {
+                    rootListings[key];
+                    pending.append(relativePath);
+                }
+                else
+                {
+                    rootListings[normalize(directory)].append(dirEntry.name);
+                }
+            }
+        }
+
+        for (auto it = rootListings.begin(); it != rootListings.end(); ++it)
+        {
+            if (!listings.contains(it.key()))
+            {
+                it.value().sort();
+                listings.insert(it.key(), it.value());
+            }
+        }
+    }
+
+    built = true;
+}
+
+bool AssetIndex::Covers(QString relativePath)
+{
+    if (!built) return false;
+
+    auto path = normalize(relativePath);
+    return indexedDirectories.contains(path.left(path.indexOf('/')));
+}
+
+AssetIndex::Entry AssetIndex::Find(QString relativePath)
+{
+    return entries.value(normalize(relativePath));
+}
+
+QString AssetIndex::Resolve(QString relativePath)
+{
+    return Find(relativePath).path;
+}
+
+QStringList AssetIndex::Files(QString relativeDir)
+{
+    return listings.value(normalize(relativeDir));
+}
+
+QString AssetIndex::normalize(QString relativePath)
+{
+    while (relativePath.startsWith('/'))
+    {
+        relativePath.remove(0, 1);
+    }
+
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    // like the file system, the names of the assets ignore the case
+    relativePath = relativePath.toLower();
+#endif
+
+    return relativePath;
+}
@@ -0,0 +1,37 @@
+#ifndef ASSETINDEX_H
+#define ASSETINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// in-memory overlay of the asset trees of the enabled mods and the game,
+// so that resolving an asset doesn't need to probe every search path.
+class AssetIndex
+{
+public:
+    struct Entry {
+        QString path;
+        int priority = -1; // index of the search path it comes from
+        bool isDir = false;
+
+        bool isValid() const { return priority >= 0; }
+    };
+
+    static void Rebuild(QStringList searchPaths);
+    static bool Covers(QString relativePath);
+
+    static Entry Find(QString relativePath);
+    static QString Resolve(QString relativePath);
+    static QStringList Files(QString relativeDir);
+
+private:
+    static QString normalize(QString relativePath);
+
+    static inline bool built = false;
+    static inline QHash<QString, Entry> entries;
+    // files of the directory that won, sorted by name
+    static inline QHash<QString, QStringList> listings;
+};
+
+#endif // ASSETINDEX_H
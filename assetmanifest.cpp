@@ -0,0 +1,213 @@
+#include "assetmanifest.h"
+#include "appsettings.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+constexpr quint32 MANIFEST_MAGIC = 0x48534d46; // "HSMF"
+constexpr quint32 MANIFEST_VERSION = 1;
+
+QVector<AssetManifest::DirEntry> AssetManifest::Entries(QString directory)
+{
+    load();
+
+    directory = QDir::cleanPath(directory);
+    used.insert(directory);
+
+    // adding, removing or renaming an entry changes the folder's time,
+    // a missing folder is -1 and has no entries anyway.
+    auto mtime = modificationTime(directory);
+    auto & cached = directories[directory];
+    if (cached.mtime == mtime)
+    {
+        return cached.entries;
+    }
+
+    cached.mtime = mtime;
+    cached.entries.clear();
+    for (auto & info : QDir(directory).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::Name))
+    {
+        cached.entries.append(DirEntry { info.fileName(), info.isDir() });
+    }
+    dirty = true;
+
+    return cached.entries;
+}
+
+QStringList AssetManifest::EntryList(QString directory, QStringList nameFilters, QDir::Filters filters)
+{
+    QStringList list;
+    for (auto & entry : Entries(directory))
+    {
+        if (entry.isDir && !(filters & QDir::Dirs)) continue;
+        if (!entry.isDir && !(filters & QDir::Files)) continue;
+
+        if (nameFilters.isEmpty() || QDir::match(nameFilters, entry.name))
+        {
+            list.append(entry.name);
+        }
+    }
+
+    return list;
+}
+
+QVariant AssetManifest::Parsed(QString filename, std::function<QVariant(QByteArray)> parse)
+{
+    load();
+
+    filename = QDir::cleanPath(filename);
+    used.insert(filename);
+
+    QFileInfo info(filename);
+    if (!info.exists())
+    {
+        return QVariant();
+    }
+
+    auto mtime = info.lastModified().toMSecsSinceEpoch();
+    auto & cached = files[filename];
+    if (cached.mtime == mtime && cached.size == info.size())
+    {
+        return cached.value;
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly))
+    {
+        return QVariant();
+    }
+
+    cached.mtime = mtime;
+    cached.size = info.size();
+    cached.value = parse(file.readAll());
+    dirty = true;
+
+    return cached.value;
+}
+
+void AssetManifest::Save(bool prune)
+{
+    load();
+
+    if (prune)
+    {
+        for (auto it = directories.begin(); it != directories.end(); )
+        {
+            if (used.contains(it.key())) ++it;
+            else { it = directories.erase(it); dirty = true; }
+        }
+        for (auto it = files.begin(); it != files.end(); )
+        {
+            if (used.contains(it.key())) ++it;
+            else { it = files.erase(it); dirty = true; }
+        }
+        used.clear();
+    }
+
+    if (!dirty) return;
+
+    QSaveFile file(manifestPath());
+    if (!file.open(QFile::WriteOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << MANIFEST_MAGIC << MANIFEST_VERSION;
+
+    stream << directories.size();
+    for (auto it = directories.cbegin(); it != directories.cend(); ++it)
+    {
+        stream << it.key() << it->mtime << it->entries.size();
+        for (auto & entry : it->entries)
+        {
+            stream << entry.name << entry.isDir;
+        }
+    }
+
+    stream << files.size();
+    for (auto it = files.cbegin(); it != files.cend(); ++it)
+    {
+        stream << it.key() << it->mtime << it->size << it->value;
+    }
+
+    if (file.commit())
+    {
+        dirty = false;
+    }
+}
+
+void AssetManifest::load()
+{
+    if (loaded) return;
+    loaded = true;
+
+    QFile file(manifestPath());
+    if (!file.open(QFile::ReadOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != MANIFEST_MAGIC || version != MANIFEST_VERSION)
+    {
+        return;
+    }
+
+    int directoriesCount;
+    stream >> directoriesCount;
+    for (int i = 0; i < directoriesCount && stream.status() == QDataStream::Ok; i++)
+    {
+        QString path;
+        Directory directory;
+        int entriesCount;
+        stream >> path >> directory.mtime >> entriesCount;
+        for (int j = 0; j < entriesCount && stream.status() == QDataStream::Ok; j++)
+        {
+            DirEntry entry;
+            stream >> entry.name >> entry.isDir;
+            directory.entries.append(entry);
+        }
+        directories.insert(path, directory);
+    }
+
+    int filesCount;
+    stream >> filesCount;
+    for (int i = 0; i < filesCount && stream.status() == QDataStream::Ok; i++)
+    {
+        QString path;
+        File cached;
+        stream >> path >> cached.mtime >> cached.size >> cached.value;
+        files.insert(path, cached);
+    }
+
+    // a truncated manifest is as good as none
+    if (stream.status() != QDataStream::Ok)
+    {
+        directories.clear();
+        files.clear();
+    }
+}
+
+QString AssetManifest::manifestPath()
+{
+    return AppSettings::GetSettingsDirectory() + "/assets.cache";
+}
+
+qint64 AssetManifest::modificationTime(QString path)
+{
+    QFileInfo info(path);
+    if (!info.isDir())
+    {
+        return -1;
+    }
+
+    return info.lastModified().toMSecsSinceEpoch();
+}
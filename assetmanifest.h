@@ -0,0 +1,59 @@
+#ifndef ASSETMANIFEST_H
+#define ASSETMANIFEST_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <QDir>
+#include <functional>
+
+// directory listings and parsed data files, kept on disk between runs
+// next to settings.ini and validated by modification times, so that a
+// warm start doesn't need to walk and parse the whole data tree.
+class AssetManifest
+{
+public:
+    struct DirEntry {
+        QString name;
+        bool isDir = false;
+    };
+
+    // both are sorted by name
+    static QVector<DirEntry> Entries(QString directory);
+    static QStringList EntryList(QString directory, QStringList nameFilters, QDir::Filters filters);
+
+    // returns what parse() made of the file's content, or a null
+    // QVariant if the file doesn't exist.
+    static QVariant Parsed(QString filename, std::function<QVariant(QByteArray)> parse);
+
+    // writes the manifest if anything changed. when pruning, forgets what
+    // hasn't been used since the last pruning (disabled mods, deleted
+    // folders...), which only a full listing of the assets can tell
+    static void Save(bool prune);
+
+private:
+    static void load();
+    static QString manifestPath();
+    static qint64 modificationTime(QString path);
+
+    struct Directory {
+        qint64 mtime = -1;
+        QVector<DirEntry> entries;
+    };
+    struct File {
+        qint64 mtime = -1;
+        qint64 size = -1;
+        QVariant value;
+    };
+
+    static inline bool loaded = false;
+    static inline bool dirty = false;
+    static inline QHash<QString, Directory> directories;
+    static inline QHash<QString, File> files;
+    static inline QSet<QString> used;
+};
+
+#endif // ASSETMANIFEST_H
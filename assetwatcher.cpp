@@ -0,0 +1,94 @@
+#include "assetwatcher.h"
+#include "assetmanifest.h"
+#include <QDir>
+
+// copying a folder of frames triggers lots of notifications
+constexpr int SETTLE_DELAY = 300;
+
+// folders whose whole tree is watched, and data files that are
+// usually modified in place (which doesn't notify their folder).
+static const QStringList watchedDirectories = { "images", "misc", "audio/music", "audio/hsm/pageloops" };
+static const QStringList watchedFiles = { "images/fonts/fontdata.ini", "misc/chardata.hsd", "misc/events.txt" };
+
+AssetWatcher::AssetWatcher()
+{
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(SETTLE_DELAY);
+
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &AssetWatcher::pathChanged);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &AssetWatcher::pathChanged);
+    connect(&settleTimer, &QTimer::timeout, [this]() {
+        auto paths = changedPaths.values();
+        changedPaths.clear();
+        emit assetsChanged(paths);
+    });
+}
+
+void AssetWatcher::watch(QStringList searchPaths)
+{
+    QStringList paths;
+
+    for (auto searchPath : searchPaths)
+    {
+        auto root = QDir(searchPath).absolutePath();
+
+        QStringList pending;
+        for (auto & directory : watchedDirectories)
+        {
+            pending.append(root + "/" + directory);
+        }
+
+        while (!pending.isEmpty())
+        {
+            auto directory = pending.takeLast();
+            if (!QFileInfo(directory).isDir()) continue;
+
+            paths.append(directory);
+            for (auto & entry : AssetManifest::Entries(directory))
+            {
+                if (entry.isDir)
+                {
+                    pending.append(directory + "/" + entry.name);
+                }
+            }
+        }
+
+        for (auto & file : watchedFiles)
+        {
+            if (QFileInfo::exists(root + "/" + file))
+            {
+                paths.append(root + "/" + file);
+            }
+        }
+    }
+
+    // only touch what differs, re-adding thousands of folders isn't free
+    QSet<QString> wanted;
+    for (auto & path : paths)
+    {
+        wanted.insert(path);
+    }
+
+    QSet<QString> watched;
+    QStringList removed;
+    for (auto & path : watcher.directories() + watcher.files())
+    {
+        watched.insert(path);
+        if (!wanted.contains(path)) removed.append(path);
+    }
+
+    QStringList added;
+    for (auto & path : paths)
+    {
+        if (!watched.contains(path)) added.append(path);
+    }
+
+    if (removed.size()) watcher.removePaths(removed);
+    if (added.size()) watcher.addPaths(added);
+}
+
+void AssetWatcher::pathChanged(QString path)
+{
+    changedPaths.insert(path);
+    settleTimer.start();
+}
@@ -0,0 +1,31 @@
+#ifndef ASSETWATCHER_H
+#define ASSETWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+
+// watches the asset folders of the game and the enabled mods, and
+// reports what changed once things have settled down.
+class AssetWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    AssetWatcher();
+
+    void watch(QStringList searchPaths);
+
+signals:
+    void assetsChanged(QStringList changedPaths);
+
+private:
+    void pathChanged(QString path);
+
+    QFileSystemWatcher watcher;
+    QTimer settleTimer;
+    QSet<QString> changedPaths;
+};
+
+#endif // ASSETWATCHER_H
@@ -0,0 +1,508 @@
+#include "autosavejournal.h"
+#include "appsettings.h"
+#include "hspreader.h"
+#include "globals.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
+
+constexpr quint32 JOURNAL_MAGIC = 0x48534a4c; // "HSJL"
+constexpr quint32 JOURNAL_VERSION = 1;
+// the journal is rewritten on top of a full copy of the page once it gets
+// too big, or from time to time while the page keeps being modified.
+constexpr qint64 COMPACT_SIZE = 256 * 1024;
+constexpr qint64 COMPACT_INTERVAL = 5 * 60 * 1000;
+
+template<typename... Args>
+static QByteArray makeRecord(const Args & ... args)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    (stream << ... << args);
+    return record;
+}
+
+static bool writeSnapshot(QString filename, AutosaveJournal::Snapshot snapshot)
+{
+    QSaveFile f(filename);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+
+    if (!HspWriter::Write(&f, snapshot))
+    {
+        f.cancelWriting();
+        return false;
+    }
+    return f.commit();
+}
+
+AutosaveJournal::AutosaveJournal()
+{
+    connect(&compactWatcher, &QFutureWatcher<bool>::finished, this, &AutosaveJournal::compacted);
+}
+
+AutosaveJournal::~AutosaveJournal()
+{
+    compactWatcher.waitForFinished();
+}
+
+void AutosaveJournal::reset(QString pageFilename, Snapshot snapshot)
+{
+    generation++;
+    journalFile.close();
+    QFile::remove(journalPath());
+
+    // a page without a file is journaled whole
+    header = Header();
+    header.pageFilename = pageFilename;
+    if (!pageFilename.isEmpty() && QFile::exists(pageFilename))
+    {
+        header.baseFilename = pageFilename;
+        Stamp(header);
+    }
+
+    journaled = snapshot;
+    active = true;
+    framesDuringCompaction.clear();
+    saving = false;
+    recordsDuringSave.clear();
+}
+
+void AutosaveJournal::setValue(int id, QString event, int column, QString value)
+{
+    // the rows of the page name their events in upper case
+    record({ makeRecord(quint8(SetValue), qint32(id), event.toUpper(), quint8(column), value) });
+}
+
+void AutosaveJournal::setElement(const HspWriter::Element & element)
+{
+    record({ makeRecord(quint8(SetElement), qint32(element.id), element.type, element.name, element.rows) });
+}
+
+void AutosaveJournal::removeElement(int id)
+{
+    record({ makeRecord(quint8(RemoveElement), qint32(id)) });
+}
+
+void AutosaveJournal::setOrder(const QVector<qint32> & order)
+{
+    if (order == Order(journaled)) return;
+
+    record({ makeRecord(quint8(SetOrder), order) });
+}
+
+void AutosaveJournal::setPage(const Snapshot & page)
+{
+    auto records = PageRecords(page);
+    // the elements that aren't in the page anymore
+    QSet<qint32> ids;
+    for (auto & element : page)
+    {
+        ids.insert(element.id);
+    }
+    for (auto & element : journaled)
+    {
+        if (!ids.contains(element.id))
+        {
+            records.prepend(makeRecord(quint8(RemoveElement), qint32(element.id)));
+        }
+    }
+
+    record(records);
+}
+
+void AutosaveJournal::beginSave()
+{
+    saving = true;
+    recordsDuringSave.clear();
+}
+
+void AutosaveJournal::saved(QString pageFilename, Snapshot snapshot)
+{
+    auto records = recordsDuringSave;
+    reset(pageFilename, snapshot);
+
+    if (!records.isEmpty())
+    {
+        record(records);
+    }
+}
+
+void AutosaveJournal::saveFailed()
+{
+    saving = false;
+    recordsDuringSave.clear();
+}
+
+void AutosaveJournal::record(const QVector<QByteArray> & records)
+{
+    if (!active) return;
+
+    auto frames = records;
+
+    // the journal is only created by the first modification
+    if (!journalFile.isOpen())
+    {
+        if (!open()) return;
+
+        if (header.baseFilename.isEmpty())
+        {
+            frames = PageRecords(journaled) + frames;
+        }
+    }
+
+    for (auto & data : records)
+    {
+        Apply(journaled, data);
+    }
+    if (saving)
+    {
+        recordsDuringSave += records;
+    }
+
+    append(frames);
+}
+
+void AutosaveJournal::discard()
+{
+    compactWatcher.waitForFinished();
+
+    generation++;
+    active = false;
+    journalFile.close();
+    QFile::remove(journalPath());
+    QFile::remove(snapshotPath(0));
+    QFile::remove(snapshotPath(1));
+}
+
+bool AutosaveJournal::hasRecovery() const
+{
+    return QFile::exists(journalPath());
+}
+
+QString AutosaveJournal::recoveryFilename() const
+{
+    QFile file(journalPath());
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    Header saved;
+    ReadHeader(stream, saved);
+    return saved.pageFilename;
+}
+
+bool AutosaveJournal::recover(QByteArray & page, QString & pageFilename, Snapshot & saved)
+{
+    QFile file(journalPath());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    Header journalHeader;
+    if (!ReadHeader(stream, journalHeader)) return false;
+
+    Snapshot snapshot;
+    if (!journalHeader.baseFilename.isEmpty())
+    {
+        // the journal only applies to the exact file it has been written for
+        auto current = journalHeader;
+        Stamp(current);
+        if (current.baseSize != journalHeader.baseSize || current.baseModified != journalHeader.baseModified) return false;
+
+        QFile base(journalHeader.baseFilename);
+        if (!base.open(QIODevice::ReadOnly)) return false;
+        snapshot = ReadSnapshot(base.readAll());
+    }
+
+    // a record cut short by a crash ends the journal
+    while (!stream.atEnd())
+    {
+        quint32 size;
+        quint16 checksum;
+        stream >> size >> checksum;
+        if (stream.status() != QDataStream::Ok || size > file.size()) break;
+
+        QByteArray record(size, Qt::Uninitialized);
+        if (stream.readRawData(record.data(), size) != int(size)) break;
+        if (qChecksum(record.constData(), size) != checksum) break;
+
+        Apply(snapshot, record);
+    }
+
+    page.clear();
+    QBuffer buffer(&page);
+    buffer.open(QIODevice::WriteOnly);
+    HspWriter::Write(&buffer, snapshot);
+
+    pageFilename = journalHeader.pageFilename;
+
+    saved.clear();
+    QFile savedFile(pageFilename);
+    if (!pageFilename.isEmpty() && savedFile.open(QIODevice::ReadOnly))
+    {
+        saved = ReadSnapshot(savedFile.readAll());
+    }
+
+    return true;
+}
+
+AutosaveJournal::Snapshot AutosaveJournal::ReadSnapshot(const QByteArray & page)
+{
+    Snapshot snapshot;
+
+    HspReader reader(page);
+    HspReader::Element line;
+    while (reader.readElement(line))
+    {
+        HspWriter::Element element;
+        element.type = line.type;
+        element.id = line.type == TYPE_WEBPAGE ? -1 : line.id;
+        element.name = line.name;
+
+        // the padding rows aren't events
+        for (auto & row : line.events)
+        {
+            if (row.isEmpty() || row.first().isEmpty()) break;
+            element.rows.append(row);
+        }
+
+        snapshot.append(element);
+    }
+
+    return snapshot;
+}
+
+bool AutosaveJournal::open()
+{
+    QSaveFile file(journalPath());
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    file.write(HeaderData(header));
+    if (!file.commit()) return false;
+
+    journalFile.setFileName(journalPath());
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Append)) return false;
+
+    sinceCompaction.start();
+    return true;
+}
+
+void AutosaveJournal::append(const QVector<QByteArray> & records)
+{
+    QByteArray frames;
+    for (auto & record : records)
+    {
+        frames += Frame(record);
+    }
+
+    journalFile.write(frames);
+    journalFile.flush();
+
+    if (compactWatcher.isRunning())
+    {
+        framesDuringCompaction += frames;
+    }
+    else if (journalFile.size() > COMPACT_SIZE || sinceCompaction.elapsed() > COMPACT_INTERVAL)
+    {
+        compact();
+    }
+}
+
+// the page is written in the background into the snapshot file that isn't
+// the base of the journal, the journal starts over from it once it's done.
+void AutosaveJournal::compact()
+{
+    compacting = journaled;
+    compactingGeneration = generation;
+    framesDuringCompaction.clear();
+    sinceCompaction.restart();
+
+    compactWatcher.setFuture(QtConcurrent::run(writeSnapshot, snapshotPath(1 - snapshotIndex), compacting));
+}
+
+void AutosaveJournal::compacted()
+{
+    compacting.clear();
+    if (compactingGeneration != generation || !journalFile.isOpen() || !compactWatcher.result()) return;
+
+    Header compactedHeader;
+    compactedHeader.pageFilename = header.pageFilename;
+    compactedHeader.baseFilename = snapshotPath(1 - snapshotIndex);
+    Stamp(compactedHeader);
+
+    // the modifications made in the meantime follow the new base
+    QSaveFile file(journalPath());
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(HeaderData(compactedHeader));
+    file.write(framesDuringCompaction);
+
+    journalFile.close();
+    bool committed = file.commit();
+    journalFile.open(QIODevice::WriteOnly | QIODevice::Append);
+    if (!committed) return;
+
+    header = compactedHeader;
+    snapshotIndex = 1 - snapshotIndex;
+    framesDuringCompaction.clear();
+}
+
+QVector<QByteArray> AutosaveJournal::PageRecords(const Snapshot & page)
+{
+    QVector<QByteArray> records;
+    for (auto & element : page)
+    {
+        records.append(makeRecord(quint8(SetElement), qint32(element.id), element.type, element.name, element.rows));
+    }
+    records.append(makeRecord(quint8(SetOrder), Order(page)));
+    return records;
+}
+
+QVector<qint32> AutosaveJournal::Order(const Snapshot & page)
+{
+    QVector<qint32> order;
+    order.reserve(page.size());
+    for (auto & element : page)
+    {
+        order.append(element.id);
+    }
+    return order;
+}
+
+// the elements are identified by their id, and their rows by their event
+void AutosaveJournal::Apply(Snapshot & snapshot, const QByteArray & record)
+{
+    QDataStream stream(record);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    auto find = [&snapshot](int id) {
+        return std::find_if(snapshot.begin(), snapshot.end(), [id](const HspWriter::Element & element) {
+            return element.id == id;
+        });
+    };
+
+    quint8 type;
+    stream >> type;
+
+    switch (type)
+    {
+    case SetValue:
+    {
+        qint32 id;
+        QString event;
+        quint8 column;
+        QString value;
+        stream >> id >> event >> column >> value;
+
+        auto element = find(id);
+        if (element == snapshot.end()) break;
+
+        for (auto & row : element->rows)
+        {
+            if (row.value(0).compare(event, Qt::CaseInsensitive) == 0)
+            {
+                while (row.size() <= column) row.append(QString());
+                row[column] = value;
+                break;
+            }
+        }
+        break;
+    }
+    case SetElement:
+    {
+        HspWriter::Element element;
+        stream >> element.id >> element.type >> element.name >> element.rows;
+
+        auto it = find(element.id);
+        if (it == snapshot.end())
+        {
+            snapshot.append(element);
+        }
+        else
+        {
+            *it = element;
+        }
+        break;
+    }
+    case RemoveElement:
+    {
+        qint32 id;
+        stream >> id;
+
+        auto it = find(id);
+        if (it != snapshot.end()) snapshot.erase(it);
+        break;
+    }
+    case SetOrder:
+    {
+        QVector<qint32> order;
+        stream >> order;
+
+        Snapshot ordered;
+        for (auto id : order)
+        {
+            auto it = find(id);
+            if (it != snapshot.end()) ordered.append(*it);
+        }
+        snapshot = ordered;
+        break;
+    }
+    }
+}
+
+QByteArray AutosaveJournal::Frame(const QByteArray & record)
+{
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << quint32(record.size()) << qChecksum(record.constData(), record.size());
+    stream.writeRawData(record.constData(), record.size());
+    return frame;
+}
+
+QByteArray AutosaveJournal::HeaderData(const Header & header)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << JOURNAL_MAGIC << JOURNAL_VERSION;
+    stream << header.pageFilename << header.baseFilename << header.baseSize << header.baseModified;
+    return data;
+}
+
+bool AutosaveJournal::ReadHeader(QDataStream & stream, Header & header)
+{
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION)
+    {
+        return false;
+    }
+
+    stream >> header.pageFilename >> header.baseFilename >> header.baseSize >> header.baseModified;
+    return stream.status() == QDataStream::Ok;
+}
+
+void AutosaveJournal::Stamp(Header & header)
+{
+    QFileInfo info(header.baseFilename);
+    header.baseSize = info.exists() ? info.size() : -1;
+    header.baseModified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+QString AutosaveJournal::journalPath() const
+{
+    return AppSettings::GetSettingsDirectory() + "/autosave.journal";
+}
+
+QString AutosaveJournal::snapshotPath(int index) const
+{
+    return AppSettings::GetSettingsDirectory() + QString("/autosave-%1.hsp").arg(index);
+}
@@ -0,0 +1,108 @@
+#ifndef AUTOSAVEJOURNAL_H
+#define AUTOSAVEJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include "hspwriter.h"
+
+class QDataStream;
+
+// appends the modifications of the page to a journal in the settings
+// directory, so that they can be replayed on top of the last saved page
+// if the editor dies before the page is saved again.
+class AutosaveJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Snapshot = QVector<HspWriter::Element>;
+
+    AutosaveJournal();
+    ~AutosaveJournal();
+
+    // the page matches 'snapshot', as saved in 'pageFilename' (empty for a new page)
+    void reset(QString pageFilename, Snapshot snapshot);
+
+    // the modifications, journaled as they happen. the webpage has the id -1
+    void setValue(int id, QString event, int column, QString value);
+    // an element created, or whose name or events changed
+    void setElement(const HspWriter::Element & element);
+    void removeElement(int id);
+    // the ids of all the elements, the webpage first
+    void setOrder(const QVector<qint32> & order);
+    // the whole page, when it can't be told what changed
+    void setPage(const Snapshot & page);
+
+    // 'snapshot' is being saved into 'pageFilename': once it is, the journal
+    // starts over from this file with the modifications made in the meantime
+    void beginSave();
+    void saved(QString pageFilename, Snapshot snapshot);
+    void saveFailed();
+
+    // the page has been closed properly, nothing to recover
+    void discard();
+
+    // a journal left by a session that didn't end properly
+    bool hasRecovery() const;
+    QString recoveryFilename() const;
+    // the replayed page, with its file and what this file contains
+    bool recover(QByteArray & page, QString & pageFilename, Snapshot & saved);
+
+private:
+    enum RecordType : quint8 {
+        SetValue,
+        SetElement,
+        RemoveElement,
+        SetOrder
+    };
+
+    struct Header {
+        QString pageFilename;
+        QString baseFilename;
+        qint64 baseSize = -1;
+        qint64 baseModified = -1;
+    };
+
+    void record(const QVector<QByteArray> & records);
+    bool open();
+    void append(const QVector<QByteArray> & records);
+    void compact();
+    void compacted();
+
+    static Snapshot ReadSnapshot(const QByteArray & page);
+    // the records building 'page' whatever it is applied to
+    static QVector<QByteArray> PageRecords(const Snapshot & page);
+    static QVector<qint32> Order(const Snapshot & page);
+    static void Apply(Snapshot & snapshot, const QByteArray & record);
+    static QByteArray Frame(const QByteArray & record);
+    static QByteArray HeaderData(const Header & header);
+    static bool ReadHeader(QDataStream & stream, Header & header);
+    static void Stamp(Header & header);
+
+    QString journalPath() const;
+    QString snapshotPath(int index) const;
+
+    QFile journalFile;
+    Header header;
+    // what the journal replays to, only written whole by the compactions
+    Snapshot journaled;
+    int generation = 0;
+    // nothing is journaled before the first reset, or once discarded
+    bool active = false;
+
+    // the records made while the page is being saved
+    bool saving = false;
+    QVector<QByteArray> recordsDuringSave;
+
+    // compactions write the page into the snapshot file unused by the journal
+    QFutureWatcher<bool> compactWatcher;
+    QElapsedTimer sinceCompaction;
+    Snapshot compacting;
+    QByteArray framesDuringCompaction;
+    int compactingGeneration = 0;
+    int snapshotIndex = 0;
+};
+
+#endif // AUTOSAVEJOURNAL_H
@@ -0,0 +1,49 @@
+QT += core gui widgets concurrent testlib
+
+QMAKE_CXXFLAGS += -std=c++2a
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# the hot paths are measured on the sources of the editor
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../animationclock.cpp \
+    ../appsettings.cpp \
+    ../assetindex.cpp \
+    ../assetmanifest.cpp \
+    ../autosavejournal.cpp \
+    ../fontdatabase.cpp \
+    ../framecache.cpp \
+    ../gif.cpp \
+    ../hspreader.cpp \
+    ../hspwriter.cpp \
+    ../page.cpp \
+    ../pageelement.cpp \
+    ../pageloader.cpp \
+    ../text.cpp \
+    ../utils.cpp \
+    pagebenchmarks.cpp \
+    syntheticdata.cpp
+
+HEADERS += \
+    ../animationclock.h \
+    ../appsettings.h \
+    ../assetindex.h \
+    ../assetmanifest.h \
+    ../autosavejournal.h \
+    ../fontdatabase.h \
+    ../framecache.h \
+    ../gif.h \
+    ../globals.h \
+    ../hspreader.h \
+    ../hspwriter.h \
+    ../page.h \
+    ../pageelement.h \
+    ../pageloader.h \
+    ../text.h \
+    ../utils.h \
+    syntheticdata.h
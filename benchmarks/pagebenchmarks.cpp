@@ -0,0 +1,472 @@
+#include "syntheticdata.h"
+#include "appsettings.h"
+#include "animationclock.h"
+#include "assetindex.h"
+#include "autosavejournal.h"
+#include "fontdatabase.h"
+#include "framecache.h"
+#include "globals.h"
+#include "hspreader.h"
+#include "hspwriter.h"
+#include "page.h"
+#include "pageloader.h"
+#include "text.h"
+#include "utils.h"
+#include <QtTest>
+#include <QApplication>
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// how many units (pixels, glyphs, elements...) a benchmark processes per
+// second, measured around QBENCHMARK and kept for the JSON report.
+class Throughput
+{
+public:
+    Throughput(QString unit, qint64 unitsPerIteration)
+        : unit(unit)
+        , unitsPerIteration(unitsPerIteration)
+    {
+        timer.start();
+    }
+
+    void iteration()
+    {
+        iterations++;
+    }
+
+    void record()
+    {
+        auto elapsed = timer.nsecsElapsed();
+        if (iterations == 0 || elapsed == 0) return;
+
+        double perSecond = double(unitsPerIteration) * iterations * 1e9 / elapsed;
+        Results.append(QJsonObject {
+            { "benchmark", QTest::currentTestFunction() },
+            { "tag", QTest::currentDataTag() },
+            { "unit", unit },
+            { "unitsPerIteration", unitsPerIteration },
+            { "iterations", iterations },
+            { "nsPerIteration", double(elapsed) / iterations },
+            { "perSecond", perSecond }
+        });
+        qInfo().noquote() << QString("%1 %2/s").arg(perSecond, 0, 'g', 4).arg(unit);
+    }
+
+    static inline QJsonArray Results;
+
+private:
+    QString unit;
+    qint64 unitsPerIteration = 0;
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+};
+
+// the hot paths of the editor, on a synthetic data directory. the
+// throughputs are written to the file named by PAGEBENCHMARKS_OUTPUT,
+// benchmarks.json by default, the timings of QtTest can be saved with -csv.
+class PageBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void changeHSL_data();
+    void changeHSL();
+    void renderText_data();
+    void renderText();
+    void regenerateFont_data();
+    void regenerateFont();
+    void fontDatabaseLoad_data();
+    void fontDatabaseLoad();
+    void loadPage_data();
+    void loadPage();
+    void writePage_data();
+    void writePage();
+
+    // not measured, the results of the code above are checked
+    void replayJournal();
+    void writeCompactJson();
+
+private:
+    void pageData();
+    void loadFonts();
+
+    QTemporaryDir root;
+    SyntheticData::DataOptions dataOptions;
+    QStringList eventsNames;
+    AppSettings settings;
+    FontDatabase fontDatabase;
+    AnimationClock animationClock;
+    QWidget host;
+};
+
+void PageBenchmarks::initTestCase()
+{
+    QVERIFY(root.isValid());
+    QVERIFY(SyntheticData::WriteDataRoot(root.path(), dataOptions));
+
+    for (int i = 0; i < dataOptions.events; i++)
+    {
+        eventsNames += SyntheticData::EventName(i);
+    }
+
+    AssetIndex::Rebuild({ root.path() });
+    loadFonts();
+
+    // the animations would only add noise
+    AnimationClock::SetManual(true);
+}
+
+void PageBenchmarks::cleanupTestCase()
+{
+    auto filename = qEnvironmentVariable("PAGEBENCHMARKS_OUTPUT", "benchmarks.json");
+
+    QFile file(filename);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(QJsonDocument(QJsonObject { { "results", Throughput::Results } }).toJson());
+}
+
+void PageBenchmarks::loadFonts()
+{
+    fontDatabase.clear();
+    fontDatabase.load(root.path() + "/images/fonts");
+}
+
+void PageBenchmarks::changeHSL_data()
+{
+    QTest::addColumn<int>("side");
+    QTest::addColumn<int>("colors");
+
+    // the gifs have few colors, recolored through their palette
+    QTest::newRow("32x32 16 colors") << 32 << 16;
+    QTest::newRow("128x128 16 colors") << 128 << 16;
+    QTest::newRow("512x512 16 colors") << 512 << 16;
+    QTest::newRow("128x128 gradient") << 128 << 0;
+    QTest::newRow("512x512 gradient") << 512 << 0;
+}
+
+void PageBenchmarks::changeHSL()
+{
+    QFETCH(int, side);
+    QFETCH(int, colors);
+
+    auto image = SyntheticData::Image(QSize(side, side), colors, 1);
+
+    Throughput throughput("pixels", side * side);
+    QBENCHMARK {
+        throughput.iteration();
+        auto recolored = Utils::ChangeHSL(image, 1.2f, 0.8f, 1.1f);
+        Q_UNUSED(recolored)
+    }
+    throughput.record();
+}
+
+void PageBenchmarks::renderText_data()
+{
+    QTest::addColumn<int>("words");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("5 words") << 5 << 1;
+    QTest::newRow("50 words") << 50 << 1;
+    QTest::newRow("500 words") << 500 << 1;
+    QTest::newRow("500 words large") << 500 << 3;
+}
+
+// every line rendered again, none of them from the cache
+void PageBenchmarks::renderText()
+{
+    QFETCH(int, words);
+    QFETCH(int, size);
+
+    auto string = SyntheticData::Words(words, 1);
+
+    Text text;
+    text.setFont("synthetic");
+    text.setFontSize(size);
+    text.setFontBold(false);
+    text.setWidth(PAGE_WIDTH);
+
+    Throughput throughput("glyphs", string.size());
+    QBENCHMARK {
+        throughput.iteration();
+        Text::ClearLineCache();
+        text.setString(QString());
+        text.setString(string);
+    }
+    throughput.record();
+}
+
+void PageBenchmarks::regenerateFont_data()
+{
+    QTest::addColumn<int>("size");
+
+    for (int size = 1; size <= dataOptions.fontSizes; size++)
+    {
+        QTest::newRow(qPrintable(QString("size %1").arg(size))) << size;
+    }
+}
+
+// switching between two fonts, each atlas is released then decoded again
+void PageBenchmarks::regenerateFont()
+{
+    QFETCH(int, size);
+
+    Text text;
+    text.setFont("synthetic");
+    text.setFontSize(size);
+
+    bool bold = false;
+    Throughput throughput("fonts", 1);
+    QBENCHMARK {
+        throughput.iteration();
+        bold = !bold;
+        text.setFontBold(bold);
+        text.setString(QString());
+    }
+    throughput.record();
+}
+
+void PageBenchmarks::fontDatabaseLoad_data()
+{
+    QTest::addColumn<int>("fonts");
+
+    QTest::newRow("18 fonts") << 18;
+    QTest::newRow("180 fonts") << 180;
+    QTest::newRow("1800 fonts") << 1800;
+}
+
+// like every start of the editor: fontdata.ini is parsed once, then read
+// back from the asset manifest
+void PageBenchmarks::fontDatabaseLoad()
+{
+    QFETCH(int, fonts);
+
+    auto directory = QString("%1/fonts%2").arg(root.path()).arg(fonts);
+    QDir().mkpath(directory);
+
+    QByteArray fontData;
+    for (int i = 0; i < fonts; i++)
+    {
+        fontData += QString("[Bench%1n]\nspacing=1\nlineheight=12\n").arg(i).toUtf8();
+        fontData += "charwidths=ABCDEFGHIJKLMNOPQRSTUVWXYZ^8^abcdefghijklmnopqrstuvwxyz^7^0123456789^6^ .,;:?!'^3\n";
+    }
+    QFile file(directory + "/fontdata.ini");
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(fontData);
+    file.close();
+
+    Throughput throughput("fonts", fonts);
+    QBENCHMARK {
+        throughput.iteration();
+        fontDatabase.clear();
+        fontDatabase.load(directory);
+    }
+    throughput.record();
+
+    loadFonts();
+}
+
+void PageBenchmarks::pageData()
+{
+    QTest::addColumn<int>("elements");
+    QTest::addColumn<int>("events");
+
+    for (int elements : { 10, 100, 1000 })
+    {
+        for (int events : { 1, 4 })
+        {
+            QTest::newRow(qPrintable(QString("%1 elements %2 events").arg(elements).arg(events))) << elements << events;
+        }
+    }
+}
+
+void PageBenchmarks::loadPage_data()
+{
+    pageData();
+}
+
+// MainWindow::parseJSON without the interface, from the bytes of the page
+// to its elements drawn, with the assets decoded again each time
+void PageBenchmarks::loadPage()
+{
+    QFETCH(int, elements);
+    QFETCH(int, events);
+
+    SyntheticData::PageOptions options;
+    options.elements = elements;
+    options.eventsPerElement = events;
+    options.lines = 40 + elements / 10;
+    auto data = SyntheticData::Page(options, dataOptions);
+
+    Throughput throughput("elements", elements);
+    QBENCHMARK {
+        throughput.iteration();
+        FrameCache::Clear();
+        Text::ClearLineCache();
+
+        Page webpage(&host);
+        PageLoader::Load(&webpage, data, eventsNames);
+        // the gifs with many frames are recolored on the thread pool
+        QThreadPool::globalInstance()->waitForDone();
+    }
+    throughput.record();
+}
+
+void PageBenchmarks::writePage_data()
+{
+    pageData();
+}
+
+// the part of MainWindow::savePage done on the worker thread, the snapshot
+// of the page taken on the GUI thread is not measured
+void PageBenchmarks::writePage()
+{
+    QFETCH(int, elements);
+    QFETCH(int, events);
+
+    SyntheticData::PageOptions options;
+    options.elements = elements;
+    options.eventsPerElement = events;
+
+    QVector<HspWriter::Element> snapshot;
+    HspReader reader(SyntheticData::Page(options, dataOptions));
+    HspReader::Element line;
+    while (reader.readElement(line))
+    {
+        snapshot.append({ line.type, line.id, line.name, line.events });
+    }
+    QCOMPARE(snapshot.size(), elements + 1);
+
+    Throughput throughput("elements", elements);
+    QBENCHMARK {
+        throughput.iteration();
+        QBuffer buffer;
+        buffer.open(QBuffer::WriteOnly);
+        HspWriter::Write(&buffer, snapshot);
+    }
+    throughput.record();
+}
+
+// the edits are journaled with the real names of the events, the rows of
+// the page name them in upper case
+void PageBenchmarks::replayJournal()
+{
+    AutosaveJournal::Snapshot page {
+        { TYPE_WEBPAGE, -1, QString(), { { "DEFAULT", "0" } } },
+        { TYPE_TEXT, 1, "text", { { "DEFAULT", "before" }, { "MIXED CASE EVENT", "before" } } }
+    };
+
+    AutosaveJournal journal;
+    journal.reset(QString(), page);
+    journal.setValue(1, "Mixed Case Event", 1, "after");
+    journal.setValue(-1, "Default", 1, "1");
+
+    QByteArray data;
+    QString pageFilename;
+    AutosaveJournal::Snapshot saved;
+    QVERIFY(journal.recover(data, pageFilename, saved));
+    journal.discard();
+
+    HspReader reader(data);
+    HspReader::Element line;
+    QVERIFY(reader.readElement(line));
+    QCOMPARE(line.events.value(0).value(1), QString("1"));
+    QVERIFY(reader.readElement(line));
+    QCOMPARE(line.events.value(0).value(1), QString("before"));
+    QCOMPARE(line.events.value(1).value(1), QString("after"));
+}
+
+// the same page as HspWriter::Write, built as a QJsonDocument
+static QByteArray compactJson(const QVector<HspWriter::Element> & elements)
+{
+    constexpr int rowsCount = 21;
+    constexpr int columnsCount = 21;
+
+    auto jsonRow = [](QStringList row) {
+        while (row.size() < columnsCount) row.append(QString());
+        return QJsonArray::fromStringList(row);
+    };
+
+    QJsonArray data;
+    for (auto & element : elements)
+    {
+        QJsonArray rows;
+        if (element.type == TYPE_WEBPAGE)
+        {
+            rows.append(jsonRow({ element.type }));
+        }
+        else
+        {
+            QJsonArray definition { element.type, element.id, element.name };
+            while (definition.size() < columnsCount) definition.append(QString());
+            rows.append(definition);
+        }
+        for (auto & row : element.rows)
+        {
+            rows.append(jsonRow(row));
+        }
+        while (rows.size() < rowsCount)
+        {
+            rows.append(jsonRow({}));
+        }
+        data.append(rows);
+    }
+
+    QJsonObject page {
+        { "c2array", true },
+        { "data", data },
+        { "size", QJsonArray { elements.size(), rowsCount, columnsCount } }
+    };
+    return QJsonDocument(page).toJson(QJsonDocument::Compact);
+}
+
+// the pages written by HspWriter are byte for byte those of QJsonDocument
+void PageBenchmarks::writeCompactJson()
+{
+    auto pair = QStringLiteral("\U0001F600");
+    QVector<HspWriter::Element> elements {
+        { TYPE_WEBPAGE, -1, QString(), { { "DEFAULT", "a \"quoted\" string", "back\\slash", "a/b" } } },
+        { TYPE_TEXT, 7, "name \"7\"", {
+            { "CONTROL", QString("\x01\x08\t\n\x0b\x0c\r\x1b\x1f\x7f"), QString(QChar(0)) + "nul" },
+            { "UNICODE", QStringLiteral("\u00e9t\u00e9"), QStringLiteral("\u6f22\u5b57"), QStringLiteral("\u20ac"), pair, "x" + pair + "y" },
+            { "SURROGATES", QString(QChar(0xd83d)), QString(QChar(0xde00)) + "x", "x" + QString(QChar(0xd83d)), QString(QChar(0xde00)) + QString(QChar(0xd83d)) }
+        } },
+        { TYPE_GIF, 123456, QStringLiteral("\u00fc"), { HspWriter::EmptyRow() } }
+    };
+
+    // a whole synthetic page too
+    SyntheticData::PageOptions options;
+    options.elements = 10;
+    options.eventsPerElement = 4;
+    HspReader reader(SyntheticData::Page(options, dataOptions));
+    HspReader::Element line;
+    while (reader.readElement(line))
+    {
+        elements.append({ line.type, line.id, line.name, line.events });
+    }
+
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    QVERIFY(HspWriter::Write(&buffer, elements));
+    QCOMPARE(buffer.data(), compactJson(elements));
+}
+
+int main(int argc, char *argv[])
+{
+    // nothing is shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    PageBenchmarks benchmarks;
+    return QTest::qExec(&benchmarks, argc, argv);
+}
+
+#include "pagebenchmarks.moc"
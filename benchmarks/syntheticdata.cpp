@@ -0,0 +1,378 @@
+#include "syntheticdata.h"
+#include "hspwriter.h"
+#include "globals.h"
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <algorithm>
+
+static bool writeFile(QString path, const QByteArray & contents)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QFile file(path);
+    return file.open(QFile::WriteOnly) && file.write(contents) == contents.size();
+}
+
+// the letters of the wordarts, in the order of their offset in the pages
+static const QStringList wordartLetters = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j",
+    "k", "l", "m", "n", "o", "p", "q", "r", "s", "t",
+    "u", "v", "w", "x", "y", "z", "zz0exclam",
+};
+
+static QSize glyphSize(int size, bool bold)
+{
+    return QSize(4 + 2 * size + (bold ? 1 : 0), 6 + 3 * size);
+}
+
+bool SyntheticData::WriteDataRoot(QString root, const DataOptions & options)
+{
+    QRandomGenerator random(options.seed);
+    bool ok = true;
+
+    // fontdata.ini is made of 4 lines per font, and each font has its atlas
+    QDir().mkpath(root + "/images/fonts");
+    QByteArray fontData;
+    for (int size = 1; size <= options.fontSizes; size++)
+    {
+        for (bool bold : { false, true })
+        {
+            auto name = FontName(size, bold);
+            auto glyph = glyphSize(size, bold);
+
+            fontData += QString("[%1]\nspacing=1\nlineheight=%2\n").arg(name).arg(glyph.height() + 2).toUtf8();
+            fontData += QString("charwidths=ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789^%1^abcdefghijklmnopqrstuvwxyz^%2^ .,;:?!'^%3\n")
+                        .arg(glyph.width())
+                        .arg(glyph.width() - 1)
+                        .arg(glyph.width() / 2).toUtf8();
+
+            ok = ok && FontAtlas(glyph.width(), glyph.height()).save(root + "/images/fonts/" + name.toLower() + ".png");
+        }
+    }
+    ok = ok && writeFile(root + "/images/fonts/fontdata.ini", fontData);
+
+    // the frames of a gif are sorted by name, its speed is the name of a file
+    for (int i = 0; i < options.gifs; i++)
+    {
+        auto directory = root + "/images/gifs/" + GifName(i);
+        int frames = random.bounded(1, options.maxFrames + 1);
+        int side = random.bounded(16, 65);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            QDir().mkpath(directory);
+            ok = ok && Image(QSize(side, side), 2 + i % 14, options.seed + i * 100 + frame).save(QString("%1/%2%3.png").arg(directory, GifName(i)).arg(frame, 2, 10, QChar('0')));
+        }
+        ok = ok && writeFile(QString("%1/%2.speed").arg(directory).arg(random.bounded(1, 11)), QByteArray());
+    }
+
+    // the previews of the page styles of the editor
+    QDir().mkpath(root + "/images/gifs/zoneselectorb");
+    for (int style = 1; style <= 49; style++)
+    {
+        ok = ok && Image(QSize(48, 24), 4, options.seed + style).save(QString("%1/images/gifs/zoneselectorb/zoneselectorb%2.png").arg(root).arg(style, 2, 10, QChar('0')));
+    }
+
+    QDir().mkpath(root + "/images/static");
+    for (int i = 0; i < options.statics; i++)
+    {
+        int side = random.bounded(16, 129);
+        ok = ok && Image(QSize(side, side), 2 + i % 14, options.seed + i).save(QString("%1/images/static/%2.png").arg(root, StaticName(i)));
+    }
+
+    QDir().mkpath(root + "/images/shapes");
+    for (int i = 0; i < options.shapes; i++)
+    {
+        ok = ok && Image(QSize(32, 32), 2, options.seed + i).save(QString("%1/images/shapes/%2.png").arg(root, ShapeName(i)));
+    }
+
+    for (int i = 0; i < options.wordarts; i++)
+    {
+        auto directory = root + "/images/wordart/" + WordartName(i);
+        QDir().mkpath(directory);
+        for (int letter = 0; letter < wordartLetters.size(); letter++)
+        {
+            ok = ok && Image(QSize(24, 32), 3, options.seed + i * 100 + letter).save(QString("%1/%2.png").arg(directory, wordartLetters[letter]));
+        }
+    }
+
+    QDir().mkpath(root + "/images/bgs");
+    for (int i = 0; i < options.backgrounds; i++)
+    {
+        ok = ok && Image(QSize(32, 32), 4, options.seed + i).save(QString("%1/images/bgs/%2").arg(root, BackgroundName(i)));
+    }
+
+    // only the title and the artist of the musics are read, the oggs aren't needed
+    for (int i = 0; i < options.musics; i++)
+    {
+        auto title = Words(random.bounded(1, 4), options.seed + i);
+        ok = ok && writeFile(QString("%1/audio/music/%2.txt").arg(root, MusicName(i)), QString("%1|%2").arg(title, UserName(i)).toUtf8());
+    }
+
+    // a c2array with a box per user, its name first
+    QJsonArray users;
+    for (int i = 0; i < options.users; i++)
+    {
+        users.append(QJsonArray { QJsonArray { UserName(i), Words(2, options.seed + i) } });
+    }
+    QJsonObject chardata {
+        { "c2array", true },
+        { "size", QJsonArray { options.users, 1, 2 } },
+        { "data", users }
+    };
+    ok = ok && writeFile(root + "/misc/chardata.hsd", QJsonDocument(chardata).toJson(QJsonDocument::Compact));
+
+    QByteArray events;
+    for (int i = 0; i < options.events; i++)
+    {
+        events += EventName(i).toUtf8() + "\n";
+    }
+    ok = ok && writeFile(root + "/misc/events.txt", events);
+
+    return ok;
+}
+
+QByteArray SyntheticData::Page(const PageOptions & page, const DataOptions & data)
+{
+    QRandomGenerator random(page.seed);
+
+    // the other events of the page, the default one first
+    QStringList eventNames { EVENT_DEFAULT };
+    for (int i = 0; i < std::min(page.eventsPerElement - 1, data.events); i++)
+    {
+        eventNames += EventName(i);
+    }
+
+    QVector<HspWriter::Element> elements;
+
+    HspWriter::Element webpage;
+    webpage.type = TYPE_WEBPAGE;
+    webpage.id = -1;
+    for (int i = 0; i < eventNames.size(); i++)
+    {
+        auto row = HspWriter::EmptyRow();
+        row[WebEvent] = eventNames[i];
+        row[WebTitle] = "Synthetic page";
+        row[WebUsername] = data.users > 0 ? UserName(page.seed % data.users) : QString();
+        row[WebHeight] = QString::number(page.lines);
+        row[WebMusic] = data.musics > 0 ? QString("audio\\music\\%1.ogg").arg(MusicName(i % data.musics)) : QString();
+        row[WebBGImage] = data.backgrounds > 0 ? BackgroundName(i % data.backgrounds) : QString();
+        row[WebMouseFX] = "0";
+        row[WebBGColor] = QString::number(random.bounded(0x1000000));
+        row[WebDescriptionAndTags] = Words(8, random.generate());
+        row[WebPageStyle] = QString::number(random.bounded(1, 50));
+        row[WebUserHOME] = "0";
+        webpage.rows.append(row);
+    }
+    elements.append(webpage);
+
+    // the images of the gifs, in proportion of each kind
+    int images = data.gifs + data.statics + data.shapes + data.wordarts;
+    auto imageName = [&](int & offset) {
+        int index = random.bounded(images);
+        offset = 0;
+        if (index < data.gifs) return GifName(index);
+        index -= data.gifs;
+        if (index < data.statics) return StaticName(index);
+        index -= data.statics;
+        if (index < data.shapes) return ShapeName(index);
+        index -= data.shapes;
+        offset = random.bounded(1, wordartLetters.size());
+        return WordartName(index);
+    };
+
+    int height = std::max(page.lines * 32 - 32, 1);
+    for (int i = 0; i < page.elements; i++)
+    {
+        HspWriter::Element element;
+        element.id = (i + 1) * 10;
+
+        bool isGif = i % 2 == 0 && images > 0;
+        element.type = isGif ? TYPE_GIF : TYPE_TEXT;
+        element.name = QString("%1 %2").arg(element.type).arg(i + 1);
+
+        for (auto & event : eventNames)
+        {
+            auto row = HspWriter::EmptyRow();
+            if (isGif)
+            {
+                int offset = 0;
+                row[GifEvent] = event;
+                row[GifX] = QString::number(random.bounded(PAGE_WIDTH));
+                row[GifY] = QString::number(random.bounded(height));
+                // a third of the gifs are recolored
+                row[GifHSL] = random.bounded(3) == 0 ? QString("%1,%2,%3").arg(random.bounded(360)).arg(random.bounded(50, 150)).arg(random.bounded(50, 150)) : "0,100,100";
+                row[GifNameOf] = imageName(offset);
+                row[GifScale] = "1.00";
+                row[GifRotation] = QString::number(random.bounded(4) == 0 ? random.bounded(360) : 0);
+                row[GifMirror] = "0";
+                row[GifFlip] = "0";
+                row[GifLawBroken] = "-1";
+                row[GifAnimFlipX] = "-1";
+                row[GifAnimFlipY] = "-1";
+                row[GifAnimFade] = "-1";
+                row[GifAnimTurn] = QString::number(random.bounded(5) == 0 ? random.bounded(1, 3) : 0);
+                row[GifAnimTurnSpeed] = QString::number(random.bounded(1, 10));
+                row[GifFPS] = "0";
+                row[GifOffset] = QString::number(offset);
+                row[GifSync] = "0";
+                row[GifAnimMouseOver] = "0";
+            }
+            else
+            {
+                int size = random.bounded(1, data.fontSizes + 1);
+                bool bold = random.bounded(2);
+
+                row[TextEvent] = event;
+                row[TextX] = QString::number(random.bounded(-50, 30));
+                row[TextY] = QString::number(random.bounded(height));
+                row[TextWidth] = QString::number(random.bounded(60, PAGE_WIDTH));
+                row[TextString] = Words(random.bounded(1, 40), random.generate());
+                row[TextColor] = QString::number(random.bounded(0x1000000));
+                row[TextFont] = "synthetic";
+                row[TextStyle] = QString("%1%2").arg(size).arg(bold ? 'b' : 'n');
+                row[TextAlign] = QString::number(random.bounded(3));
+                row[TextLawBroken] = "-1";
+                row[TextAnimation] = QString::number(random.bounded(6) == 0 ? random.bounded(1, 4) : 0);
+                row[TextAnimSpeed] = QString::number(random.bounded(1, 10));
+                row[TextColorFadeTo] = "-1";
+                row[TextColorFadeSpeed] = "0";
+                row[TextNoContent] = "0";
+            }
+            element.rows.append(row);
+        }
+
+        elements.append(element);
+    }
+
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    HspWriter::Write(&buffer, elements);
+    return buffer.data();
+}
+
+QString SyntheticData::Words(int count, quint32 seed)
+{
+    QRandomGenerator random(seed);
+
+    QStringList words;
+    for (int i = 0; i < count; i++)
+    {
+        QString word;
+        int length = random.bounded(1, 10);
+        for (int j = 0; j < length; j++)
+        {
+            word += QChar('a' + random.bounded(26));
+        }
+        words += word;
+    }
+    return words.join(' ');
+}
+
+QString SyntheticData::FontName(int size, bool bold)
+{
+    return QString("Synthetic%1%2").arg(size).arg(bold ? 'b' : 'n');
+}
+
+QString SyntheticData::GifName(int index)
+{
+    return QString("synthetic_gif_%1").arg(index);
+}
+
+QString SyntheticData::StaticName(int index)
+{
+    return QString("synthetic_static_%1").arg(index);
+}
+
+QString SyntheticData::ShapeName(int index)
+{
+    return QString("synthetic_shape_%1").arg(index);
+}
+
+QString SyntheticData::WordartName(int index)
+{
+    return QString("synthetic_wordart_%1").arg(index);
+}
+
+QString SyntheticData::BackgroundName(int index)
+{
+    return QString("synthetic_bg_%1.png").arg(index);
+}
+
+QString SyntheticData::MusicName(int index)
+{
+    return QString("synthetic_music_%1").arg(index);
+}
+
+QString SyntheticData::UserName(int index)
+{
+    return QString("synthetic_user_%1").arg(index);
+}
+
+QString SyntheticData::EventName(int index)
+{
+    return QString("SYNTHETIC_EVENT_%1").arg(index);
+}
+
+QImage SyntheticData::Image(QSize size, int colors, quint32 seed)
+{
+    QRandomGenerator random(seed);
+
+    QVector<QRgb> palette;
+    for (int i = 0; i < colors; i++)
+    {
+        palette.append(0xFF000000 | random.bounded(0x1000000));
+    }
+
+    QImage image(size, QImage::Format_ARGB32);
+    for (int y = 0; y < size.height(); y++)
+    {
+        auto line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); x++)
+        {
+            if (colors > 0)
+            {
+                // blocks of colors, with a transparent border like most gifs
+                bool border = x == 0 || y == 0 || x == size.width() - 1 || y == size.height() - 1;
+                line[x] = border ? 0 : palette[((x / 4) + (y / 4) * 3) % colors];
+            }
+            else
+            {
+                line[x] = qRgb(x * 255 / size.width(), y * 255 / size.height(), (x + y + seed) % 256);
+            }
+        }
+    }
+
+    return image;
+}
+
+QImage SyntheticData::FontAtlas(int glyphWidth, int glyphHeight)
+{
+    QImage atlas(glyphWidth * 8, glyphHeight * 12, QImage::Format_ARGB32);
+    atlas.fill(Qt::transparent);
+
+    // every glyph is a different pattern of white pixels, colored by the texts
+    for (int glyph = 0; glyph < 8 * 12; glyph++)
+    {
+        int left = glyph % 8 * glyphWidth;
+        int top = glyph / 8 * glyphHeight;
+        for (int y = 1; y < glyphHeight - 1; y++)
+        {
+            for (int x = 0; x < glyphWidth - 1; x++)
+            {
+                if ((x * 7 + y * 3 + glyph) % 5 < 2)
+                {
+                    atlas.setPixel(left + x, top + y, qRgba(255, 255, 255, 255));
+                }
+            }
+        }
+    }
+
+    return atlas;
+}
@@ -0,0 +1,59 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+// a made up data directory of the game, and pages using its assets, so
+// that the code can be measured without the files of the game. the same
+// options and seed always give the same files.
+class SyntheticData
+{
+public:
+    struct DataOptions {
+        int gifs = 16;
+        int maxFrames = 6;
+        int statics = 8;
+        int shapes = 4;
+        // every letter of a wordart is an image of its folder
+        int wordarts = 2;
+        int backgrounds = 4;
+        // the fonts are the sizes 1 to fontSizes (9 at most), bold or not
+        int fontSizes = 3;
+        int events = 8;
+        int musics = 4;
+        int users = 8;
+        quint32 seed = 1;
+    };
+
+    struct PageOptions {
+        int elements = 100;
+        // the default event included
+        int eventsPerElement = 1;
+        int lines = 40;
+        quint32 seed = 1;
+    };
+
+    static bool WriteDataRoot(QString root, const DataOptions & options);
+    static QByteArray Page(const PageOptions & page, const DataOptions & data);
+
+    // lowercase words of 1 to 9 letters
+    static QString Words(int count, quint32 seed);
+    static QString FontName(int size, bool bold);
+    static QString GifName(int index);
+    static QString StaticName(int index);
+    static QString ShapeName(int index);
+    static QString WordartName(int index);
+    static QString BackgroundName(int index);
+    static QString MusicName(int index);
+    static QString UserName(int index);
+    static QString EventName(int index);
+    // 'colors' 0 for a gradient with as many colors as pixels
+    static QImage Image(QSize size, int colors, quint32 seed);
+    // the fonts in an atlas of 8 x 12 glyphs, like the ones of the game
+    static QImage FontAtlas(int glyphWidth, int glyphHeight);
+};
+
+#endif // SYNTHETICDATA_H
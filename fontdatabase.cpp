@@ -1,4 +1,5 @@
 #include "fontdatabase.h"
+#include "assetmanifest.h"
 #include <QSettings>
 #include <QFile>
 #include <QSet>
@@ -8,68 +9,72 @@ FontDatabase::FontDatabase()
     instance = this;
 }
 
-void FontDatabase::load(QString directory)
+// fontdata.ini is made of 4 lines per font:
+// [name]
+// spacing=N
+// lineheight=N
+// charwidths=chars^width^chars^width...
+static QVariant parseFontData(QByteArray data)
 {
-    if (QFile(directory + "/fontdata.ini").exists())
+    auto lines = data.split('\n');
+    for (auto & line : lines)
     {
-        QFile fontdata(directory + "/fontdata.ini");
-        if (fontdata.open(QFile::ReadOnly))
+        line = line.trimmed();
+    }
+    lines.removeAll(QByteArray());
+    assert(lines.size() % 4 == 0);
+
+    QVariantList fontsData;
+    for (int i = 0; i < lines.size(); i += 4)
+    {
+        QVariantMap fontData;
+        fontData["name"] = QString(lines[i + 0].replace("[", "").replace("]", "").toLower());
+        fontData["spacing"] = lines[i + 1].mid(8).toInt();
+        fontData["lineheight"] = lines[i + 2].mid(11).toInt();
+
+        QVariantList widths;
+        auto charwidths = lines[i + 3].mid(11).split('^');
+        for (int j = 0; j + 1 < charwidths.size(); j += 2)
         {
-            auto lines = fontdata.readAll().split('\n');
-            for (auto & line : lines)
-            {
-                line = line.trimmed();
-            }
-            lines.removeAll(QByteArray());
-            assert(lines.size() % 4 == 0);
+            widths << charwidths[j] << charwidths[j + 1].toInt();
+        }
+        fontData["widths"] = widths;
+
+        fontsData.append(fontData);
+    }
 
-            for (int i = 0; i < lines.size(); i += 4)
+    return fontsData;
+}
+
+void FontDatabase::load(QString directory)
+{
+    // parsed once, then read back from the manifest until the file changes
+    auto fontsData = AssetManifest::Parsed(directory + "/fontdata.ini", parseFontData).toList();
+    for (auto & data : fontsData)
+    {
+        auto fontData = data.toMap();
+        auto name = fontData["name"].toString();
+
+        auto widths = fontData["widths"].toList();
+        for (int i = 0; i + 1 < widths.size(); i += 2)
+        {
+            auto width = widths[i + 1].toInt();
+            for (auto c : widths[i].toByteArray())
             {
-                auto name = lines[i + 0].replace("[", "").replace("]", "").toLower();
-                auto spacing = lines[i + 1].mid(8).toInt();
-                auto lineheight = lines[i + 2].mid(11).toInt();
-                auto charwidths = lines[i + 3].mid(11).split('^');
-
-                QVector<char> chars;
-
-                bool processChars = true;
-                for (auto d : charwidths)
-                {
-                    if (processChars)
-                    {
-                        chars.clear();
-
-                        for (auto c : d)
-                        {
-                            chars.append(c);
-                        }
-                    }
-                    else
-                    {
-                        auto width = d.toInt();
-
-                        for (auto c : chars)
-                        {
-                            fonts[name].widths[c] = width;
-                        }
-
-                        chars.clear();
-                    }
-
-                    processChars = !processChars;
-                }
-
-                fonts[name].spacing = spacing;
-                fonts[name].lineheight = lineheight;
-                fonts[name].path = directory;
+                fonts[name].widths[c] = width;
             }
         }
+
+        fonts[name].spacing = fontData["spacing"].toInt();
+        fonts[name].lineheight = fontData["lineheight"].toInt();
+        fonts[name].path = directory;
     }
 }
 
 void FontDatabase::clear()
 {
     fonts.clear();
+    atlases.clear();
 }
 
 FontDatabase::FontData & FontDatabase::GetFont(QString name)
@@ -96,6 +101,42 @@ QPixmap FontDatabase::GetFontAtlas(QString name)
     return QPixmap(QString("%1/%2.png").arg(instance->fonts[name].path, name.toLower()));
 }
 
+QSharedPointer<const FontDatabase::FontAtlas> FontDatabase::AcquireFontAtlas(QString name)
+{
+    static const QString alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.,;:?!-_~#\"'&()[]|`\\/@°+=*€$$<> ";
+
+    auto atlas = instance->atlases.value(name).toStrongRef();
+    if (atlas)
+    {
+        return atlas;
+    }
+
+    auto newAtlas = QSharedPointer<FontAtlas>::create();
+    newAtlas->pixmap = GetFontAtlas(name);
+    newAtlas->glyphWidth = newAtlas->pixmap.width() / 8;
+    newAtlas->glyphHeight = newAtlas->pixmap.height() / 12;
+
+    for (int xx = 0, yy = 0; auto c : alphabet)
+    {
+        newAtlas->glyphs[c] = QRect(xx * newAtlas->glyphWidth, yy * newAtlas->glyphHeight, newAtlas->glyphWidth, newAtlas->glyphHeight);
+
+        xx++;
+        if (xx >= 8)
+        {
+            yy++;
+            xx = 0;
+        }
+    }
+
+    instance->atlases[name] = newAtlas;
+    return newAtlas;
+}
+
+QRect FontDatabase::FontAtlas::glyphRect(QChar c) const
+{
+    return glyphs.value(c);
+}
+
 int FontDatabase::FontData::getWidth(char c, int defaultWidth)
 {
     if (widths.contains(c))
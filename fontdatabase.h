@@ -4,6 +4,10 @@
 #include <QString>
 #include <QMap>
 #include <QPixmap>
+#include <QHash>
+#include <QRect>
+#include <QSharedPointer>
+#include <QWeakPointer>
 
 class FontDatabase
 {
@@ -22,13 +26,26 @@ public:
         int getWidth(char c, int defaultWidth);
     };
 
+    // one decoded atlas per font, shared by every text using it.
+    struct FontAtlas {
+        QPixmap pixmap;
+        int glyphWidth = 0;
+        int glyphHeight = 0;
+        QHash<QChar, QRect> glyphs;
+
+        QRect glyphRect(QChar c) const;
+    };
+
     static FontData & GetFont(QString name);
     static QList<QString> GetFonts();
     static QPixmap GetFontAtlas(QString name);
+    static QSharedPointer<const FontAtlas> AcquireFontAtlas(QString name);
 
 private:
     static inline FontDatabase * instance = nullptr;
     QMap<QString, FontData> fonts;
+    // released as soon as the last text using it changes font
+    QMap<QString, QWeakPointer<const FontAtlas>> atlases;
 };
 
 #endif // FONTDATABASE_H
@@ -0,0 +1,94 @@
+#include "framecache.h"
+
+QString FrameCache::HSLKey(QString source, int h, int s, int l)
+{
+    return QString("%1|%2,%3,%4").arg(source).arg(h).arg(s).arg(l);
+}
+
+bool FrameCache::Find(QString key, QVector<QPixmap> & frames)
+{
+    auto cached = cache.object(key);
+    if (!cached)
+    {
+        return false;
+    }
+
+    frames = *cached;
+    return true;
+}
+
+void FrameCache::Insert(QString key, QVector<QPixmap> frames)
+{
+    if (frames.isEmpty()) return;
+
+    cache.insert(key, new QVector<QPixmap>(frames), cost(frames));
+}
+
+bool FrameCache::FindDecoded(QString source, QVector<QPixmap> & frames, int & speed)
+{
+    auto cached = decoded.object(source);
+    if (!cached)
+    {
+        return false;
+    }
+
+    frames = cached->frames;
+    speed = cached->speed;
+    return true;
+}
+
+void FrameCache::InsertDecoded(QString source, QVector<QPixmap> frames, int speed)
+{
+    if (source.isEmpty() || frames.isEmpty()) return;
+
+    decoded.insert(source, new Decoded { frames, speed }, cost(frames));
+}
+
+bool FrameCache::ContainsDecoded(QString source)
+{
+    return decoded.contains(source);
+}
+
+int FrameCache::cost(const QVector<QPixmap> & frames)
+{
+    int cost = 0;
+    for (auto & frame : frames)
+    {
+        cost += frame.width() * frame.height() * 4 / 1024 + 1;
+    }
+
+    return cost;
+}
+
+void FrameCache::Invalidate(QStringList changedPaths)
+{
+    for (auto & key : cache.keys())
+    {
+        for (auto & path : changedPaths)
+        {
+            if (key.startsWith(path + "/") || key.startsWith(path + "|"))
+            {
+                cache.remove(key);
+                break;
+            }
+        }
+    }
+
+    for (auto & source : decoded.keys())
+    {
+        for (auto & path : changedPaths)
+        {
+            if (source == path || source.startsWith(path + "/"))
+            {
+                decoded.remove(source);
+                break;
+            }
+        }
+    }
+}
+
+void FrameCache::Clear()
+{
+    cache.clear();
+    decoded.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QCache>
+#include <QPixmap>
+#include <QVector>
+
+class FrameCache
+{
+public:
+    static QString HSLKey(QString source, int h, int s, int l);
+
+    static bool Find(QString key, QVector<QPixmap> & frames);
+    static void Insert(QString key, QVector<QPixmap> frames);
+    // frames as decoded from disk, with the speed of their gif folder
+    static bool FindDecoded(QString source, QVector<QPixmap> & frames, int & speed);
+    static void InsertDecoded(QString source, QVector<QPixmap> frames, int speed);
+    static bool ContainsDecoded(QString source);
+
+    static void Invalidate(QStringList changedPaths);
+    static void Clear();
+
+private:
+    static int cost(const QVector<QPixmap> & frames);
+
+    struct Decoded {
+        QVector<QPixmap> frames;
+        int speed = 0;
+    };
+
+    // cost is in KiB, 128 MiB of recolored frames
+    static inline QCache<QString, QVector<QPixmap>> cache { 128 * 1024 };
+    // and 64 MiB of decoded ones
+    static inline QCache<QString, Decoded> decoded { 64 * 1024 };
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,21 @@
+QT += core gui
+
+QMAKE_CXXFLAGS += -std=c++2a
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# the files are made by the synthetic data of the benchmarks
+INCLUDEPATH += .. ../benchmarks
+
+SOURCES += \
+    ../benchmarks/syntheticdata.cpp \
+    ../hspwriter.cpp \
+    main.cpp
+
+HEADERS += \
+    ../benchmarks/syntheticdata.h \
+    ../globals.h \
+    ../hspwriter.h
@@ -0,0 +1,118 @@
+#include "syntheticdata.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+// writes a made up data directory of the game and pages using it, to try
+// the editor and measure it without the files of the game:
+//
+//     PageGenerator [options] <directory>
+//
+// the data directory is <directory>/data, the one selected by the editor
+// for <directory>, and the pages are written into <directory>/pages.
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("PageGenerator");
+
+    SyntheticData::DataOptions data;
+    SyntheticData::PageOptions page;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a synthetic data directory of the game and Hypnospace pages using its assets.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("directory", "The directory where the data directory and the pages are written.", "<directory>");
+
+    QCommandLineOption pagesOption({ "p", "pages" }, "The number of pages.", "pages", "1");
+    QCommandLineOption elementsOption({ "e", "elements" }, "The number of elements of each page, half gifs and half texts.", "elements", QString::number(page.elements));
+    QCommandLineOption eventsOption("events-per-element", "The number of events of each element, the default one included.", "events", QString::number(page.eventsPerElement));
+    QCommandLineOption linesOption({ "l", "lines" }, "The height of the pages in lines.", "lines", QString::number(page.lines));
+    QCommandLineOption seedOption("seed", "The same seed always gives the same files.", "seed", QString::number(data.seed));
+    QCommandLineOption gifsOption("gifs", "The number of gifs.", "gifs", QString::number(data.gifs));
+    QCommandLineOption framesOption("max-frames", "The most frames of a gif.", "frames", QString::number(data.maxFrames));
+    QCommandLineOption staticsOption("statics", "The number of static images.", "statics", QString::number(data.statics));
+    QCommandLineOption shapesOption("shapes", "The number of shapes.", "shapes", QString::number(data.shapes));
+    QCommandLineOption wordartsOption("wordarts", "The number of wordarts.", "wordarts", QString::number(data.wordarts));
+    QCommandLineOption backgroundsOption("backgrounds", "The number of backgrounds.", "backgrounds", QString::number(data.backgrounds));
+    QCommandLineOption fontSizesOption("font-sizes", "The sizes of the font, from 1 to 9, each bold or not.", "sizes", QString::number(data.fontSizes));
+    QCommandLineOption dataEventsOption("data-events", "The number of events of misc/events.txt.", "events", QString::number(data.events));
+    QCommandLineOption musicsOption("musics", "The number of musics.", "musics", QString::number(data.musics));
+    QCommandLineOption usersOption("users", "The number of users of misc/chardata.hsd.", "users", QString::number(data.users));
+    QCommandLineOption pagesOnlyOption("pages-only", "Only writes the pages, the data directory has already been generated with the same options.");
+    parser.addOptions({ pagesOption, elementsOption, eventsOption, linesOption, seedOption, gifsOption, framesOption, staticsOption, shapesOption,
+                        wordartsOption, backgroundsOption, fontSizesOption, dataEventsOption, musicsOption, usersOption, pagesOnlyOption });
+    parser.process(a);
+
+    QTextStream err(stderr);
+
+    if (parser.positionalArguments().size() != 1)
+    {
+        parser.showHelp(2);
+    }
+
+    auto pages = parser.value(pagesOption).toInt();
+    page.elements = parser.value(elementsOption).toInt();
+    page.eventsPerElement = parser.value(eventsOption).toInt();
+    page.lines = parser.value(linesOption).toInt();
+    data.seed = parser.value(seedOption).toUInt();
+    data.gifs = parser.value(gifsOption).toInt();
+    data.maxFrames = parser.value(framesOption).toInt();
+    data.statics = parser.value(staticsOption).toInt();
+    data.shapes = parser.value(shapesOption).toInt();
+    data.wordarts = parser.value(wordartsOption).toInt();
+    data.backgrounds = parser.value(backgroundsOption).toInt();
+    data.fontSizes = parser.value(fontSizesOption).toInt();
+    data.events = parser.value(dataEventsOption).toInt();
+    data.musics = parser.value(musicsOption).toInt();
+    data.users = parser.value(usersOption).toInt();
+
+    if (pages < 0 || page.elements < 0 || page.eventsPerElement < 1 || page.lines < 1)
+    {
+        err << "Invalid number of pages, elements, events or lines.\n";
+        return 2;
+    }
+    if (data.gifs < 0 || data.maxFrames < 1 || data.statics < 0 || data.shapes < 0 || data.wordarts < 0 || data.backgrounds < 0
+            || data.fontSizes < 1 || data.fontSizes > 9 || data.events < 0 || data.musics < 0 || data.users < 0)
+    {
+        err << "Invalid number of assets.\n";
+        return 2;
+    }
+    if (page.eventsPerElement > data.events + 1)
+    {
+        err << QString("Only %1 events per element, misc/events.txt has %2 events.\n").arg(data.events + 1).arg(data.events);
+    }
+
+    auto directory = QFileInfo(parser.positionalArguments().first()).absoluteFilePath();
+    auto root = directory + "/data";
+
+    if (!parser.isSet(pagesOnlyOption))
+    {
+        if (!SyntheticData::WriteDataRoot(root, data))
+        {
+            err << QString("Unable to write the data directory '%1'.\n").arg(root);
+            return 1;
+        }
+        err << QString("Data directory written to '%1'.\n").arg(root);
+    }
+
+    QDir().mkpath(directory + "/pages");
+    for (int i = 0; i < pages; i++)
+    {
+        // every page has its own elements
+        page.seed = data.seed + i;
+
+        auto filename = QString("%1/pages/synthetic_page_%2.hsp").arg(directory).arg(i + 1);
+        QFile file(filename);
+        if (!file.open(QFile::WriteOnly) || file.write(SyntheticData::Page(page, data)) == -1)
+        {
+            err << QString("Unable to write '%1'.\n").arg(filename);
+            return 1;
+        }
+    }
+    err << QString("%1 pages of %2 elements written to '%3/pages'.\n").arg(pages).arg(page.elements).arg(directory);
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "gif.h"
 #include "utils.h"
+#include "framecache.h"
 #include "appsettings.h"
+#include "assetindex.h"
 #include "globals.h"
 #include <QPainter>
 #include <QBitmap>
@@ -11,6 +13,7 @@
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QApplication>
+#include <QtConcurrent>
 
 static const constexpr std::array<const char *, 41> characters = {
     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
@@ -24,7 +27,18 @@ static const constexpr std::array<const char *, 41> characters = {
 Gif::Gif()
 {
     setFlags(ItemIsMovable | ItemIsSelectable | ItemSendsGeometryChanges);
-    timerId = startTimer(1000 / 60);
+
+    connect(&hslWatcher, &QFutureWatcher<QImage>::finished, this, [this]() {
+        if (hslWatcher.isCanceled()) return;
+
+        frames.clear();
+        for (auto & image : hslWatcher.future().results())
+        {
+            frames.push_back(QPixmap::fromImage(image));
+        }
+        FrameCache::Insert(hslKey, frames);
+        bakedDirty = true;
+    });
 }
 
 void Gif::addFrame(QString filename)
@@ -32,6 +46,7 @@ void Gif::addFrame(QString filename)
     QPixmap pix(filename);
     events[currentEvent].originalFrames.push_back(pix);
     frames.push_back(pix);
+    bakedDirty = true;
 }
 
 void Gif::setSpeed(int speed)
@@ -55,14 +70,50 @@ void Gif::setHSL(int h, int s, int l)
     evData.S = s;
     evData.L = l;
 
-    frames.clear();
-    for (auto pix : evData.originalFrames)
+    // recolored once the frames are loaded
+    if (IsBulkLoading())
     {
-        frames.push_back(Utils::ChangeHSL(pix, h / 100.0f, s / 100.0f, l / 100.0f));
+        AppSettings::SetPageDirty();
+        return;
+    }
+
+    // the same image with the same colors is often placed many times on a page.
+    hslKey = FrameCache::HSLKey(evData.source, h, s, l);
+    if (!evData.source.isEmpty() && FrameCache::Find(hslKey, frames))
+    {
+        hslWatcher.cancel();
+    }
+    else if (evData.originalFrames.size() > 1)
+    {
+        // recolor the frames on the thread pool, the current
+        // ones stay on screen until the whole batch is done.
+        QVector<QImage> images;
+        for (auto & pix : evData.originalFrames)
+        {
+            images.push_back(pix.toImage());
+        }
+
+        // only the latest colors matter
+        hslWatcher.cancel();
+        hslWatcher.setFuture(QtConcurrent::mapped(images, [h, s, l](const QImage & image) {
+            return Utils::ChangeHSL(image, h / 100.0f, s / 100.0f, l / 100.0f);
+        }));
+    }
+    else
+    {
+        hslWatcher.cancel();
+
+        frames.clear();
+        for (auto pix : evData.originalFrames)
+        {
+            frames.push_back(Utils::ChangeHSL(pix, h / 100.0f, s / 100.0f, l / 100.0f));
+        }
+        FrameCache::Insert(hslKey, frames);
     }
+    bakedDirty = true;
 
     if (frames.size() == 1)
-        timerEvent(nullptr);
+        animate(0, true);
     AppSettings::SetPageDirty();
 }
 
@@ -77,7 +128,10 @@ void Gif::setFrameOffset(int f)
     {
         currentFrame = 0;
     }
-    refresh();
+    if (!IsBulkLoading())
+    {
+        refresh();
+    }
     AppSettings::SetPageDirty();
 }
 
@@ -138,7 +192,7 @@ void Gif::mirror(bool active)
     events[currentEvent].mirrored = active;
 
     if (frames.size() == 1)
-        timerEvent(nullptr);
+        animate(0, true);
     AppSettings::SetPageDirty();
 }
 
@@ -147,7 +201,7 @@ void Gif::flip(bool active)
     events[currentEvent].flipped = active;
 
     if (frames.size() == 1)
-        timerEvent(nullptr);
+        animate(0, true);
     AppSettings::SetPageDirty();
 }
 
@@ -228,7 +282,8 @@ QPixmap Gif::unscaledPixmap() const
         return frames[currentFrame];
     }
 
-    return frames[0];
+    // nothing until the first frames are recolored
+    return frames.isEmpty() ? QPixmap() : frames[0];
 }
 
 bool Gif::mirrored() const
@@ -316,10 +371,8 @@ int Gif::gifAnimation() const
     return events[currentEvent].gifAnimation;
 }
 
-void Gif::timerEvent(QTimerEvent *event)
+bool Gif::animate(float dt, bool visible)
 {
-    Q_UNUSED(event)
-    float dt = 1.f / 60.f;
     auto & evData = events[currentEvent];
 
     if (fps > 0 && (evData.gifAnimation == GIF_ANIMATION || (evData.gifAnimation == GIF_MOUSE_OVER_ANIMATION && isUnderMouse())))
@@ -327,7 +380,7 @@ void Gif::timerEvent(QTimerEvent *event)
         fpsProgress += dt;
         if (fpsProgress > fps)
         {
-            currentFrame = (currentFrame + 1) % frames.size();
+            currentFrame = frames.isEmpty() ? 0 : (currentFrame + 1) % frames.size();
             fpsProgress -= fps;
         }
     }
@@ -365,48 +418,88 @@ void Gif::timerEvent(QTimerEvent *event)
         currentFrame = 0;
     }
 
-    QPixmap frame = frames[currentFrame];
-    QTransform transform;
+    if (evData.flip3DX)
+    {
+        flip3DXProgress += evData.flip3DXSpeed * 0.1 * dt;
+    }
+
+    if (evData.flip3DY)
+    {
+        flip3DYProgress += evData.flip3DYSpeed * 0.1 * dt;
+    }
+
+    switch (evData.swingOrSpin)
+    {
+    case 1:
+        swingOrSpinProgress += evData.swingOrSpinSpeed * 0.25 * dt;
+        break;
+    case 2:
+        swingOrSpinProgress += evData.swingOrSpinSpeed * 0.1 * dt;
+        break;
+    }
 
-    if (evData.mirrored)
+    if (!visible)
     {
-        transform.scale(-1, 1);
+        return false;
     }
 
-    if (evData.flipped)
+    // mirror and flip don't change between ticks, they are baked into the frames.
+    if (bakedDirty || bakedMirrored != evData.mirrored || bakedFlipped != evData.flipped)
     {
-        transform.scale(1, -1);
+        bakeFrames();
     }
 
+    if (bakedFrames.isEmpty())
+    {
+        return false;
+    }
+
+    bool changed = false;
+
+    auto & frame = bakedFrames.at(currentFrame);
+    if (frame.cacheKey() != pixmap().cacheKey())
+    {
+        setPixmap(frame);
+        setOffset(-frame.width() / 2, -frame.height() / 2);
+        changed = true;
+    }
+
+    // the animated parts are applied by the item's transform instead of
+    // re-rasterising the pixmap every tick.
+    QTransform transform;
+
     if (evData.flip3DX)
     {
-        flip3DXProgress += evData.flip3DXSpeed * 0.1 * dt;
         transform.scale(std::sin(flip3DXProgress), 1);
     }
 
     if (evData.flip3DY)
     {
-        flip3DYProgress += evData.flip3DYSpeed * 0.1 * dt;
         transform.scale(1, std::sin(flip3DYProgress));
     }
 
     switch (evData.swingOrSpin)
     {
     case 1:
-        swingOrSpinProgress += evData.swingOrSpinSpeed * 0.25 * dt;
         transform.rotate(std::sin(swingOrSpinProgress) * 20);
         break;
     case 2:
-        swingOrSpinProgress += evData.swingOrSpinSpeed * 0.1 * dt;
         transform.rotateRadians(swingOrSpinProgress);
         break;
     }
 
-    frame = frame.transformed(transform);
+    // the mirror used to be applied after the animation, since it's
+    // now done first, the animation is mirrored to give the same result.
+    auto mirror = QTransform::fromScale(bakedMirrored ? -1 : 1, bakedFlipped ? -1 : 1);
+    transform = mirror * transform * mirror;
 
-    setPixmap(frame);
-    setOffset(-frame.width() / 2, -frame.height() / 2);
-    update();
+    if (transform != QGraphicsItem::transform())
+    {
+        setTransform(transform);
+        changed = true;
+    }
+
+    return changed;
 }
 
 QVariant Gif::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant & value)
@@ -421,6 +514,29 @@ QVariant Gif::itemChange(QGraphicsItem::GraphicsItemChange change, const QVarian
     return QGraphicsItem::itemChange(change, value);
 }
 
+void Gif::bakeFrames()
+{
+    auto & evData = events[currentEvent];
+
+    bakedMirrored = evData.mirrored;
+    bakedFlipped = evData.flipped;
+    bakedDirty = false;
+
+    if (!bakedMirrored && !bakedFlipped)
+    {
+        bakedFrames = frames;
+        return;
+    }
+
+    auto mirror = QTransform::fromScale(bakedMirrored ? -1 : 1, bakedFlipped ? -1 : 1);
+
+    bakedFrames.clear();
+    for (auto & frame : frames)
+    {
+        bakedFrames.push_back(frame.transformed(mirror));
+    }
+}
+
 void Gif::resetAllAnimations()
 {
     swingOrSpinProgress = 0;
@@ -440,58 +556,34 @@ void Gif::resetProgress()
 void Gif::refresh()
 {
     auto & ev = events[currentEvent];
-    ev.originalFrames.clear();
-    frames.clear();
-    setSpeed(0);
+    bakedDirty = true;
 
-    QString nameOf = ev.nameOf.toLower();
+    // the source only depends on nameOf and the wordart offset,
+    // and is resolved from the asset index without touching the disk.
+    auto asset = resolveAsset(ev);
 
-    auto searchPaths = AppSettings::GetSearchPaths();
-    for (auto path : searchPaths)
+    // switching events or selections keeps the same source most of the
+    // time, and the same image is often used by several elements.
+    if (asset.source.isEmpty() || asset.source != ev.source || ev.originalFrames.isEmpty())
     {
-        if (QFileInfo fi(path + "/images/gifs/" + nameOf); fi.isDir())
-        {
-            QDir dir(fi.absoluteFilePath());
-            for (auto entry : dir.entryInfoList(QDir::Files, QDir::Name))
-            {
-                if (entry.suffix() == "speed")
-                {
-                    auto spd = entry.baseName().toInt();
-                    setSpeed(spd);
-                }
-                else
-                {
-                    addFrame(entry.absoluteFilePath());
-                }
-            }
-            break;
-        }
-        else if (QFile(path + "/images/static/" + nameOf + ".png").exists())
-        {
-            addFrame(path + "/images/static/" + nameOf + ".png");
-            break;
-        }
-        else if (QFile(path + "/images/shapes/" + nameOf + ".png").exists())
-        {
-            addFrame(path + "/images/shapes/" + nameOf + ".png");
-            break;
-        }
-        else if (QFileInfo fi(path + "/images/wordart/" + nameOf.toLower()); fi.isDir())
+        ev.originalFrames.clear();
+        ev.speed = asset.speed;
+
+        if (!FrameCache::FindDecoded(asset.source, ev.originalFrames, ev.speed))
         {
-            auto letter = "0";
-            if (ev.offsetFrame > 0 && ev.offsetFrame < static_cast<int>(characters.size()))
+            for (auto & file : asset.files)
             {
-                letter = characters[ev.offsetFrame];
-                if (!QFile(QString("%1/%2.png").arg(fi.absoluteFilePath()).arg(letter)).exists())
-                {
-                    letter = "0";
-                }
+                ev.originalFrames.push_back(QPixmap(file));
             }
-            addFrame(QString("%1/%2.png").arg(fi.absoluteFilePath()).arg(letter));
-            break;
+
+            FrameCache::InsertDecoded(asset.source, ev.originalFrames, ev.speed);
         }
     }
 
+    // the frames on screen are replaced by setHSL, once recolored
+    ev.source = asset.source;
+    setSpeed(ev.speed);
+
     setHSL(ev.H, ev.S, ev.L);
     setHSRotation(ev.angle);
     setHSScale(ev.scale);
@@ -504,8 +596,120 @@ void Gif::refresh()
     if (ev.originalFrames.size() == 1)
     {
         setSpeed(0);
-        timerEvent(nullptr);
+        animate(0, true);
+    }
+}
+
+void Gif::assetsChanged(const QStringList & changedPaths)
+{
+    auto & ev = events[currentEvent];
+
+    // another search path may now provide the asset
+    bool changed = resolveAsset(ev).source != ev.source;
+    for (auto & path : changedPaths)
+    {
+        // all the events using these frames must decode them again
+        for (auto & data : events)
+        {
+            if (data.source == path || data.source.startsWith(path + "/"))
+            {
+                data.originalFrames.clear();
+                changed = changed || &data == &ev;
+            }
+        }
+    }
+
+    if (changed)
+    {
+        refresh();
+    }
+}
+
+QVector<Gif::Asset> Gif::assets() const
+{
+    QVector<Asset> list;
+    for (auto it = events.cbegin(); it != events.cend(); ++it)
+    {
+        if (it.key() != EVENT_DEFAULT)
+        {
+            list.append(resolveAsset(it.value()));
+        }
     }
+
+    if (events.contains(EVENT_DEFAULT))
+    {
+        list.append(resolveAsset(events[EVENT_DEFAULT]));
+    }
+
+    return list;
+}
+
+Gif::Asset Gif::resolveAsset(const EventData & ev)
+{
+    QString nameOf = ev.nameOf.toLower();
+
+    // the search paths are looked into one after the other, and in each
+    // of them the gifs come first, then static images, shapes and wordart.
+    const std::array<QString, 4> candidates = {
+        "images/gifs/" + nameOf,
+        "images/static/" + nameOf + ".png",
+        "images/shapes/" + nameOf + ".png",
+        "images/wordart/" + nameOf,
+    };
+
+    int kind = -1;
+    AssetIndex::Entry found;
+    for (int i = 0; i < static_cast<int>(candidates.size()); i++)
+    {
+        auto entry = AssetIndex::Find(candidates[i]);
+        bool usable = (i == 0 || i == 3) ? entry.isDir : entry.isValid();
+        if (usable && (!found.isValid() || entry.priority < found.priority))
+        {
+            found = entry;
+            kind = i;
+        }
+    }
+
+    Asset asset;
+
+    if (kind == 0)
+    {
+        asset.source = found.path;
+        for (auto & file : AssetIndex::Files(candidates[0]))
+        {
+            QFileInfo entry(asset.source + "/" + file);
+            if (entry.suffix() == "speed")
+            {
+                asset.speed = entry.baseName().toInt();
+            }
+            else
+            {
+                asset.files.append(entry.absoluteFilePath());
+            }
+        }
+    }
+    else if (kind == 3)
+    {
+        auto letter = "0";
+        if (ev.offsetFrame > 0 && ev.offsetFrame < static_cast<int>(characters.size()))
+        {
+            letter = characters[ev.offsetFrame];
+            // the letter must come from the same folder
+            if (AssetIndex::Find(QString("%1/%2.png").arg(candidates[3]).arg(letter)).priority != found.priority)
+            {
+                letter = "0";
+            }
+        }
+        asset.source = QString("%1/%2.png").arg(found.path).arg(letter);
+        asset.files.append(asset.source);
+    }
+    else if (kind != -1)
+    {
+        asset.source = found.path;
+        asset.files.append(asset.source);
+    }
+
+    return asset;
 }
 
 void Gif::setEvent(QString name)
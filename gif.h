@@ -4,6 +4,7 @@
 #include "pageelement.h"
 #include <QPixmap>
 #include <QGraphicsPixmapItem>
+#include <QFutureWatcher>
 
 class Gif : public PageElement, public QGraphicsPixmapItem
 {
@@ -13,7 +14,17 @@ class Gif : public PageElement, public QGraphicsPixmapItem
 public:
     Gif();
     ElementType elementType() const override { return ElementType::Gif; }
+    struct Asset {
+        QString source;
+        QStringList files;
+        int speed = 0;
+    };
+
     void refresh() override;
+    void assetsChanged(const QStringList & changedPaths) override;
+    // the assets used by every event, the default one last
+    QVector<Asset> assets() const;
+    bool animate(float dt, bool visible) override;
 
     void setEvent(QString name) override;
     void clearEvent(QString name) override;
@@ -74,7 +85,6 @@ public:
     int gifAnimation() const;
 
 protected:
-    void timerEvent(QTimerEvent *event) override;
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
 private:
@@ -82,6 +92,7 @@ private:
     friend class GifSlider;
     friend class PageSettings;
 
+    void bakeFrames();
     void resetAllAnimations();
     void resetProgress();
 
@@ -92,6 +103,7 @@ private:
         bool flipped = false;
         int H = 0, S = 100, L = 100;
         QString nameOf;
+        QString source;
         int angle = 0;
         float scale = 1;
         int swingOrSpin = 0;
@@ -106,11 +118,20 @@ private:
         int offsetFrame = 0;
         int gifAnimation = 0;
         QVector<QPixmap> originalFrames;
+        int speed = 0;
     };
 
+    static Asset resolveAsset(const EventData & ev);
+
     QMap<QString, EventData> events;
 
     QVector<QPixmap> frames;
+    QVector<QPixmap> bakedFrames;
+    bool bakedDirty = true;
+    bool bakedMirrored = false;
+    bool bakedFlipped = false;
+    QFutureWatcher<QImage> hslWatcher;
+    QString hslKey;
     int currentFrame = 0;
     float swingOrSpinProgress = 0;
     float flip3DXProgress = 0;
@@ -118,7 +139,6 @@ private:
     float fadeProgress = 0;
     float fps = 0;
     float fpsProgress = 0;
-    int timerId = -1;
 };
 
 #endif // GIF_H
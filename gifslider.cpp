@@ -1,10 +1,11 @@
 #include "gifslider.h"
 #include "gif.h"
+#include "animationclock.h"
 #include <QPainter>
 
 GifSlider::GifSlider(QWidget *parent) : QWidget(parent)
 {
-    startTimer(10);
+    connect(AnimationClock::Get(), &AnimationClock::ticked, this, QOverload<>::of(&QWidget::update));
 }
 
 GifSlider::~GifSlider() = default;
@@ -25,10 +26,3 @@ void GifSlider::paintEvent(QPaintEvent * event)
     auto pixmap = gif->unscaledPixmap();
     p.drawPixmap(rect(), pixmap);
 }
-
-void GifSlider::timerEvent(QTimerEvent * event)
-{
-    Q_UNUSED(event)
-
-    update();
-}
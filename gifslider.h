@@ -16,11 +16,9 @@ public:
 
 protected:
     void paintEvent(QPaintEvent * event) override;
-    void timerEvent(QTimerEvent * event) override;
 
 private:
     Gif * gif = nullptr;
-    int timerId = -1;
 };
 
 #endif // GIFSLIDER_H
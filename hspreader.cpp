@@ -0,0 +1,323 @@
+#include "hspreader.h"
+#include <QLocale>
+#include <cstdlib>
+#include <cstring>
+
+HspReader::HspReader(const QByteArray & data)
+    : current(data.constData())
+    , end(data.constData() + data.size())
+{
+}
+
+bool HspReader::readElement(Element & element)
+{
+    if (error) return false;
+    if (!inData && !findData()) return false;
+
+    skipWhitespace();
+    if (consume(']'))
+    {
+        // end of the page, the rest of the object isn't needed
+        inData = false;
+        current = end;
+        return false;
+    }
+
+    if (!firstElement && !consume(',')) return fail();
+    firstElement = false;
+
+    element = Element();
+
+    skipWhitespace();
+    if (!consume('[')) return fail();
+
+    bool firstRow = true;
+    bool definitionRead = false;
+    while (true)
+    {
+        skipWhitespace();
+        if (consume(']')) break;
+        if (!firstRow && !consume(',')) return fail();
+        firstRow = false;
+
+        if (!definitionRead)
+        {
+            // type, id and name, read like QJsonValue::toString() and toInt() do
+            definitionRead = true;
+
+            skipWhitespace();
+            if (!consume('['))
+            {
+                if (!skipValue()) return fail();
+                continue;
+            }
+
+            for (int column = 0; ; column++)
+            {
+                skipWhitespace();
+                if (consume(']')) break;
+                if (column > 0 && !consume(',')) return fail();
+
+                QString value;
+                bool isString = false;
+                double number = 0;
+                if (!readValue(value, isString, number)) return fail();
+
+                if (column == 0 && isString) element.type = value;
+                else if (column == 1 && !isString && int(number) == number) element.id = int(number);
+                else if (column == 2 && isString) element.name = value;
+            }
+            continue;
+        }
+
+        QStringList row;
+        if (!readRow(row)) return fail();
+        element.events.append(row);
+    }
+
+    return true;
+}
+
+bool HspReader::hasError() const
+{
+    return error;
+}
+
+bool HspReader::findData()
+{
+    skipWhitespace();
+    if (!consume('{')) return fail();
+
+    bool firstKey = true;
+    while (true)
+    {
+        skipWhitespace();
+        if (consume('}'))
+        {
+            // no data, an empty page
+            current = end;
+            return false;
+        }
+        if (!firstKey && !consume(',')) return fail();
+        firstKey = false;
+
+        skipWhitespace();
+        QString key;
+        if (!consume('"') || !readString(key)) return fail();
+
+        skipWhitespace();
+        if (!consume(':')) return fail();
+        skipWhitespace();
+
+        if (key == "data")
+        {
+            if (!consume('['))
+            {
+                // not an array, as if there was no data
+                current = end;
+                return false;
+            }
+
+            inData = true;
+            firstElement = true;
+            return true;
+        }
+
+        if (!skipValue()) return fail();
+    }
+}
+
+bool HspReader::readRow(QStringList & row)
+{
+    skipWhitespace();
+    if (!consume('['))
+    {
+        // anything else gives an empty list
+        return skipValue();
+    }
+
+    for (bool first = true; ; first = false)
+    {
+        skipWhitespace();
+        if (consume(']')) return true;
+        if (!first && !consume(',')) return false;
+
+        QString value;
+        bool isString = false;
+        double number = 0;
+        if (!readValue(value, isString, number)) return false;
+        row.append(value);
+    }
+}
+
+bool HspReader::readValue(QString & value, bool & isString, double & number)
+{
+    skipWhitespace();
+    if (current >= end) return false;
+
+    isString = false;
+    value.clear();
+
+    switch (*current)
+    {
+    case '"':
+        current++;
+        isString = true;
+        return readString(value);
+    case 't':
+        if (end - current < 4 || std::strncmp(current, "true", 4)) return false;
+        current += 4;
+        value = "true";
+        return true;
+    case 'f':
+        if (end - current < 5 || std::strncmp(current, "false", 5)) return false;
+        current += 5;
+        value = "false";
+        return true;
+    case 'n':
+        if (end - current < 4 || std::strncmp(current, "null", 4)) return false;
+        current += 4;
+        return true;
+    case '[':
+    case '{':
+        // nested values become empty strings
+        return skipValue();
+    default:
+        if (!readNumber(number)) return false;
+        value = QString::number(number, 'g', QLocale::FloatingPointShortest);
+        return true;
+    }
+}
+
+bool HspReader::readString(QString & value)
+{
+    // the opening quote has been consumed, most strings have
+    // nothing to unescape and are converted in one go.
+    value.clear();
+    auto start = current;
+    while (current < end)
+    {
+        if (*current == '"')
+        {
+            value += QString::fromUtf8(start, int(current - start));
+            current++;
+            return true;
+        }
+
+        if (*current != '\\')
+        {
+            current++;
+            continue;
+        }
+
+        value += QString::fromUtf8(start, int(current - start));
+        current++;
+        if (current >= end) return false;
+
+        switch (*current++)
+        {
+        case '"': value += '"'; break;
+        case '\\': value += '\\'; break;
+        case '/': value += '/'; break;
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'u':
+        {
+            // UTF-16 code units, surrogate pairs end up next to each other
+            if (end - current < 4) return false;
+            bool ok = false;
+            auto code = QByteArray(current, 4).toUShort(&ok, 16);
+            if (!ok) return false;
+            value += QChar(code);
+            current += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        start = current;
+    }
+
+    return false;
+}
+
+bool HspReader::readNumber(double & number)
+{
+    auto start = current;
+    if (current < end && *current == '-') current++;
+    while (current < end && ((*current >= '0' && *current <= '9') || *current == '.' || *current == 'e' || *current == 'E' || *current == '+' || *current == '-'))
+    {
+        current++;
+    }
+
+    if (current == start) return false;
+
+    bool ok = false;
+    number = QByteArray(start, int(current - start)).toDouble(&ok);
+    return ok;
+}
+
+bool HspReader::skipValue()
+{
+    skipWhitespace();
+    if (current >= end) return false;
+
+    if (*current == '[' || *current == '{')
+    {
+        char closing = *current == '[' ? ']' : '}';
+        current++;
+
+        for (bool first = true; ; first = false)
+        {
+            skipWhitespace();
+            if (consume(closing)) return true;
+            if (!first && !consume(',')) return false;
+
+            if (closing == '}')
+            {
+                skipWhitespace();
+                QString key;
+                if (!consume('"') || !readString(key)) return false;
+                skipWhitespace();
+                if (!consume(':')) return false;
+            }
+
+            if (!skipValue()) return false;
+        }
+    }
+
+    QString value;
+    bool isString;
+    double number;
+    return readValue(value, isString, number);
+}
+
+bool HspReader::consume(char c)
+{
+    if (current < end && *current == c)
+    {
+        current++;
+        return true;
+    }
+
+    return false;
+}
+
+void HspReader::skipWhitespace()
+{
+    while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r'))
+    {
+        current++;
+    }
+}
+
+bool HspReader::fail()
+{
+    error = true;
+    current = end;
+    return false;
+}
@@ -0,0 +1,46 @@
+#ifndef HSPREADER_H
+#define HSPREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// reads the c2array JSON of a .hsp page straight from its bytes, one
+// element at a time, with the fields converted the way
+// QJsonValue::toVariant().toString() would.
+class HspReader
+{
+public:
+    struct Element {
+        QString type;
+        int id = 0;
+        QString name;
+        QVector<QStringList> events;
+    };
+
+    explicit HspReader(const QByteArray & data);
+
+    // false at the end of the page or on malformed data
+    bool readElement(Element & element);
+    bool hasError() const;
+
+private:
+    bool findData();
+    bool readRow(QStringList & row);
+    bool readValue(QString & value, bool & isString, double & number);
+    bool readString(QString & value);
+    bool readNumber(double & number);
+    bool skipValue();
+    bool consume(char c);
+    void skipWhitespace();
+    bool fail();
+
+    const char * current = nullptr;
+    const char * end = nullptr;
+    bool inData = false;
+    bool firstElement = true;
+    bool error = false;
+};
+
+#endif // HSPREADER_H
@@ -0,0 +1,219 @@
+#include "hspwriter.h"
+#include "globals.h"
+#include <QIODevice>
+#include <algorithm>
+
+// every element of a page has 21 rows of 21 columns
+constexpr int PAGE_ROWS = 21;
+constexpr int PAGE_COLUMNS = 21;
+constexpr int FLUSH_SIZE = 64 * 1024;
+
+static char hexDigit(uint u)
+{
+    return u < 0xa ? '0' + u : 'a' + u - 0xa;
+}
+
+HspWriter::HspWriter(QIODevice * device)
+    : device(device)
+{
+    // the keys of a QJsonObject are sorted: c2array, data, then size
+    buffer.reserve(FLUSH_SIZE + 4096);
+    buffer += "{\"c2array\":true,\"data\":[";
+}
+
+void HspWriter::beginElement()
+{
+    if (elementsCount > 0) buffer += ',';
+    buffer += '[';
+    elementsCount++;
+    rowsCount = 0;
+}
+
+void HspWriter::writeDefinition(const QString & type, int id, const QString & name)
+{
+    beginRow();
+    writeString(type);
+    buffer += ',';
+    buffer += QByteArray::number(id);
+    buffer += ',';
+    writeString(name);
+    for (int column = 3; column < PAGE_COLUMNS; column++)
+    {
+        buffer += ",\"\"";
+    }
+    buffer += ']';
+}
+
+void HspWriter::writeRow(const QStringList & row)
+{
+    beginRow();
+    for (int column = 0; column < std::max<int>(row.size(), PAGE_COLUMNS); column++)
+    {
+        if (column > 0) buffer += ',';
+        if (column < row.size())
+        {
+            writeString(row[column]);
+        }
+        else
+        {
+            buffer += "\"\"";
+        }
+    }
+    buffer += ']';
+}
+
+void HspWriter::endElement()
+{
+    while (rowsCount < PAGE_ROWS)
+    {
+        writeRow({});
+    }
+    buffer += ']';
+    flush();
+}
+
+bool HspWriter::finish()
+{
+    buffer += "],\"size\":[";
+    buffer += QByteArray::number(elementsCount);
+    buffer += ',';
+    buffer += QByteArray::number(PAGE_ROWS);
+    buffer += ',';
+    buffer += QByteArray::number(PAGE_COLUMNS);
+    buffer += "]}";
+
+    flush();
+    return !error;
+}
+
+QStringList HspWriter::EmptyRow()
+{
+    QStringList row;
+    row.reserve(PAGE_COLUMNS);
+    for (int column = 0; column < PAGE_COLUMNS; column++)
+    {
+        row += QString();
+    }
+    return row;
+}
+
+bool HspWriter::Write(QIODevice * device, const QVector<Element> & elements)
+{
+    HspWriter writer(device);
+
+    for (auto & element : elements)
+    {
+        writer.beginElement();
+        if (element.type == TYPE_WEBPAGE)
+        {
+            writer.writeRow({ element.type });
+        }
+        else
+        {
+            writer.writeDefinition(element.type, element.id, element.name);
+        }
+        for (auto & row : element.rows)
+        {
+            writer.writeRow(row);
+        }
+        writer.endElement();
+    }
+
+    return writer.finish();
+}
+
+void HspWriter::beginRow()
+{
+    if (rowsCount > 0) buffer += ',';
+    buffer += '[';
+    rowsCount++;
+
+    if (buffer.size() >= FLUSH_SIZE)
+    {
+        flush();
+    }
+}
+
+// same escaping as the compact QJsonDocument writer: quotes, backslashes and
+// control characters only, everything else as UTF-8.
+void HspWriter::writeString(const QString & string)
+{
+    buffer += '"';
+
+    auto src = string.constData();
+    auto end = src + string.size();
+    while (src != end)
+    {
+        uint u = src->unicode();
+        src++;
+
+        if (u < 0x80)
+        {
+            if (u < 0x20 || u == '"' || u == '\\')
+            {
+                buffer += '\\';
+                switch (u)
+                {
+                case '"': buffer += '"'; break;
+                case '\\': buffer += '\\'; break;
+                case '\b': buffer += 'b'; break;
+                case '\f': buffer += 'f'; break;
+                case '\n': buffer += 'n'; break;
+                case '\r': buffer += 'r'; break;
+                case '\t': buffer += 't'; break;
+                default:
+                    buffer += "u00";
+                    buffer += hexDigit(u >> 4);
+                    buffer += hexDigit(u & 0xf);
+                }
+            }
+            else
+            {
+                buffer += char(u);
+            }
+        }
+        else if (u < 0x800)
+        {
+            buffer += char(0xc0 | (u >> 6));
+            buffer += char(0x80 | (u & 0x3f));
+        }
+        else if (QChar::isHighSurrogate(u) && src != end && src->isLowSurrogate())
+        {
+            uint ucs4 = QChar::surrogateToUcs4(u, src->unicode());
+            src++;
+            buffer += char(0xf0 | (ucs4 >> 18));
+            buffer += char(0x80 | ((ucs4 >> 12) & 0x3f));
+            buffer += char(0x80 | ((ucs4 >> 6) & 0x3f));
+            buffer += char(0x80 | (ucs4 & 0x3f));
+        }
+        else if (QChar::isSurrogate(u))
+        {
+            // a lone surrogate can't be encoded, it's escaped instead
+            buffer += "\\u";
+            buffer += hexDigit(u >> 12);
+            buffer += hexDigit((u >> 8) & 0xf);
+            buffer += hexDigit((u >> 4) & 0xf);
+            buffer += hexDigit(u & 0xf);
+        }
+        else
+        {
+            buffer += char(0xe0 | (u >> 12));
+            buffer += char(0x80 | ((u >> 6) & 0x3f));
+            buffer += char(0x80 | (u & 0x3f));
+        }
+    }
+
+    buffer += '"';
+}
+
+void HspWriter::flush()
+{
+    if (buffer.isEmpty()) return;
+
+    if (!error && device->write(buffer) != buffer.size())
+    {
+        error = true;
+    }
+    // keeps the reserved capacity
+    buffer.resize(0);
+}
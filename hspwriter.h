@@ -0,0 +1,53 @@
+#ifndef HSPWRITER_H
+#define HSPWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+
+// writes the c2array JSON of a .hsp page straight into a device, one
+// element at a time, byte for byte like QJsonDocument::Compact would.
+class HspWriter
+{
+public:
+    // a copy of one element of a page, the webpage has no id
+    struct Element {
+        QString type;
+        int id = 0;
+        QString name;
+        QVector<QStringList> rows;
+    };
+
+    explicit HspWriter(QIODevice * device);
+
+    void beginElement();
+    // the definition row of a gif or a text, with its id as a number
+    void writeDefinition(const QString & type, int id, const QString & name);
+    // missing columns are written as empty strings
+    void writeRow(const QStringList & row);
+    // pads the element with empty rows
+    void endElement();
+
+    // false if anything couldn't be written
+    bool finish();
+
+    static QStringList EmptyRow();
+    // writes a whole page, can be called from any thread
+    static bool Write(QIODevice * device, const QVector<Element> & elements);
+
+private:
+    void beginRow();
+    void writeString(const QString & string);
+    void flush();
+
+    QIODevice * device = nullptr;
+    QByteArray buffer;
+    int elementsCount = 0;
+    int rowsCount = 0;
+    bool error = false;
+};
+
+#endif // HSPWRITER_H
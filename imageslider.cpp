@@ -1,5 +1,7 @@
 #include "imageslider.h"
 #include "appsettings.h"
+#include "assetindex.h"
+#include "assetmanifest.h"
 #include <QPainter>
 #include <QSet>
 #include <QDir>
@@ -42,7 +44,7 @@ void ImageSlider::refresh()
     auto paths = AppSettings::GetSearchPaths();
     for (auto path : paths)
     {
-        auto files = QDir(path + "/images/bgs").entryList(QStringList() << "*.png", QDir::Files);
+        auto files = AssetManifest::EntryList(path + "/images/bgs", QStringList() << "*.png", QDir::Files);
         for (auto f : files)
         {
             uniqueBG.insert(f);
@@ -105,14 +107,10 @@ void ImageSlider::paintEvent(QPaintEvent * event)
 
 QPixmap ImageSlider::getPixmap(QString name)
 {
-    auto paths = AppSettings::GetSearchPaths();
-    for (auto path : paths)
+    auto img = AssetIndex::Resolve("images/bgs/" + name);
+    if (!img.isEmpty())
     {
-        auto img = path + "/images/bgs/" + name;
-        if (QFile(img).exists())
-        {
-            return QPixmap(img);
-        }
+        return QPixmap(img);
     }
 
     return QPixmap();
@@ -2,6 +2,11 @@
 #include "ui_mainwindow.h"
 #include "ui_pagesettings.h"
 #include "modsmanager.h"
+#include "assetindex.h"
+#include "assetmanifest.h"
+#include "framecache.h"
+#include "hspreader.h"
+#include "pageloader.h"
 #include "appsettings.h"
 #include "globals.h"
 #include "gif.h"
@@ -9,12 +14,18 @@
 #include "eventslist.h"
 #include "eventslistfiltermodel.h"
 #include <QFileDialog>
+#include <QSaveFile>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QHBoxLayout>
 #include <QScrollArea>
 #include <algorithm>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QtConcurrent>
+#include <QInputDialog>
+#include <QTimer>
 
 #define CHECK_MODIFICATIONS { \
         if (AppSettings::IsPageDirty()) \
@@ -47,14 +58,11 @@ int colorToInt(QColor color)
     return color.red() | (color.green() << 8) | (color.blue() << 16);
 }
 
-QColor intToColor(int color)
+// the data of an event as setEvent() would select it, without creating it
+template<typename EventData>
+EventData eventData(const QMap<QString, EventData> & events, const QString & name, const QString & current)
 {
-    if (color < 0) return QColor(QColor::Invalid);
-
-    int r = (color >> 0) & 0xFF;
-    int g = (color >> 8) & 0xFF;
-    int b = (color >> 16) & 0xFF;
-    return QColor(r, g, b);
+    return events.contains(name) ? events.value(name) : events.value(current);
 }
 
 MainWindow::MainWindow(QWidget *parent)
@@ -63,6 +71,10 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
+    // permanent, so that it doesn't hide the other messages
+    repaintedPixelsLabel = new QLabel;
+    ui->statusbar->addPermanentWidget(repaintedPixelsLabel);
+
     area = new QWidget;
     area->setFixedWidth(PAGE_WIDTH * ZOOM);
 
@@ -75,8 +87,18 @@ MainWindow::MainWindow(QWidget *parent)
             settings->select(newSel);
         }
     });
-    connect(settings, &PageSettings::createElement, this, &MainWindow::createElement);
-    connect(settings, &PageSettings::updateZOrder, this, &MainWindow::updateZOrder);
+    connect(settings, &PageSettings::createElement, [&](QString type, QJsonArray definition, QStringList eventData) {
+        auto element = createElement(type, definition, eventData);
+        if (element)
+        {
+            recordCreation(element->data(ROLE_ID).toInt());
+        }
+    });
+    connect(settings, &PageSettings::deleteElement, this, &MainWindow::deleteElement);
+    connect(settings, &PageSettings::updateZOrder, [&]() {
+        updateZOrder();
+        journalOrder();
+    });
     connect(settings, &PageSettings::pageTitleChanged, [&](QString title) {
         setWindowTitle(title);
     });
@@ -95,26 +117,53 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->action_Quit, &QAction::triggered, this, &MainWindow::close);
     connect(ui->action_Mods, &QAction::triggered, this, &MainWindow::openModsWindow);
     connect(ui->action_Refresh, &QAction::triggered, this, &MainWindow::refresh);
+    connect(ui->action_Undo, &QAction::triggered, this, &MainWindow::undo);
+    connect(ui->action_Redo, &QAction::triggered, this, &MainWindow::redo);
+    connect(ui->action_Undo_Memory, &QAction::triggered, this, &MainWindow::setUndoBudget);
+    connect(ui->action_Partial_Repaints, &QAction::toggled, [&](bool checked) {
+        webpage->setDirtyRectsEnabled(checked);
+    });
+    connect(&assetWatcher, &AssetWatcher::assetsChanged, this, &MainWindow::applyAssetChanges);
+    connect(&saveWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::pageSaved);
+
+    undoStack.setBudget(AppSettings::GetUndoBudget());
+    connect(&undoStack, &UndoStack::changed, [&]() {
+        ui->action_Undo->setEnabled(undoStack.canUndo());
+        ui->action_Redo->setEnabled(undoStack.canRedo());
+    });
+    // the rows seen before an edit are taken once the selection settled
+    connect(settings->ui->elementsList, &QListWidget::currentItemChanged, this, &MainWindow::scheduleCapture);
+    connect(settings->ui->elementsEventsList, &QListWidget::currentItemChanged, this, &MainWindow::scheduleCapture);
+    connect(settings->ui->webpageEventsList, &QListWidget::currentItemChanged, this, &MainWindow::scheduleCapture);
+    AppSettings::SetPageModifiedCallback([&]() {
+        scheduleCapture();
+    });
 
     refresh();
 
-    newPage();
+    recoverPage();
 }
 
 MainWindow::~MainWindow()
 {
+    AppSettings::SetPageModifiedCallback(nullptr);
     delete ui;
 }
 
 void MainWindow::closeEvent(QCloseEvent * event)
 {
+    finishSaving();
+
     event->setAccepted(false);
     CHECK_MODIFICATIONS
     event->setAccepted(true);
+
+    journal.discard();
 }
 
 void MainWindow::newPage()
 {
+    finishSaving();
     CHECK_MODIFICATIONS
 
     QJsonObject emptyPage;
@@ -150,10 +199,12 @@ void MainWindow::newPage()
     settings->reset();
 
     AppSettings::SetPageDirty(false);
+    journal.reset(QString(), snapshotPage());
 }
 
 void MainWindow::openPage()
 {
+    finishSaving();
     CHECK_MODIFICATIONS
 
     auto filename = QFileDialog::getOpenFileName(this, "Open page", QString(), "Hypnospace pages (*.hsp)");
@@ -167,24 +218,8 @@ void MainWindow::openPage()
 
             openedFilename = filename;
 
-            parseJSON(contents);
-
-            settings->ui->webpageEventsList->clear();
-            for (auto name : webpage->activeEvents())
-            {
-                settings->ui->webpageEventsList->addItem(name);
-            }
-            settings->ui->webpageEventsList->setCurrentRow(0);
-
-            auto item = settings->ui->elementsList->item(0);
-            if (item)
-            {
-                settings->ui->elementsList->setCurrentItem(item, QItemSelectionModel::Clear | QItemSelectionModel::SelectCurrent);
-
-                settings->ui->elementsEventsList->setCurrentRow(0);
-            }
-
-            AppSettings::SetPageDirty(false);
+            loadPage(contents);
+            journal.reset(openedFilename, snapshotPage());
         }
         else
         {
@@ -193,100 +228,69 @@ void MainWindow::openPage()
     }
 }
 
-void MainWindow::savePage()
+void MainWindow::loadPage(QByteArray contents)
 {
-    QJsonObject object;
-    object["c2array"] = true;
-    QJsonArray size;
-    size.append(settings->ui->elementsList->count() + 1);
-    size.append(21);
-    size.append(21);
-    object["size"] = size;
-
-    QJsonArray data;
+    parseJSON(contents);
 
-    for (auto i = -1; i < settings->ui->elementsList->count(); i++)
+    settings->ui->webpageEventsList->clear();
+    for (auto name : webpage->activeEvents())
     {
-        QJsonArray element;
-
-        if (i == -1)
-        {
-            auto definition = emptyArray();
-            definition[DefType] = TYPE_WEBPAGE;
-            element.append(definition);
+        settings->ui->webpageEventsList->addItem(name);
+    }
+    settings->ui->webpageEventsList->setCurrentRow(0);
 
-            auto savedEvent = webpage->currentEvent;
+    auto item = settings->ui->elementsList->item(0);
+    if (item)
+    {
+        settings->ui->elementsList->setCurrentItem(item, QItemSelectionModel::Clear | QItemSelectionModel::SelectCurrent);
 
-            auto webpageEvents = settings->ui->webpageEventsList;
-            for (int row = 0; row < webpageEvents->count(); row++)
-            {
-                auto evName = webpageEvents->item(row)->text();
-                webpage->setEvent(evName);
-
-                auto metadata = emptyArray();
-                metadata[WebEvent] = evName.toUpper();
-                metadata[WebTitle] = webpage->title();
-                metadata[WebUsername] = webpage->owner();
-                metadata[WebHeight] = QString::number(webpage->linesCount());
-                metadata[WebMusic] = webpage->music();
-                metadata[WebBGImage] = webpage->background();
-                metadata[WebMouseFX] = QString::number(webpage->cursor());
-                metadata[WebBGColor] = QString::number(colorToInt(webpage->backgroundColor()));
-                metadata[WebDescriptionAndTags] = webpage->description();
-                metadata[WebPageStyle] = QString::number(webpage->pageStyle());
-                metadata[WebUserHOME] = webpage->isUserHomePage ? "1" : "0";
-                metadata[WebOnLoadScript] = webpage->onLoadScript();
-                element.append(metadata);
-            }
+        settings->ui->elementsEventsList->setCurrentRow(0);
+    }
 
-            webpage->setEvent(savedEvent);
-        }
-        else
-        {
-            auto item = settings->ui->elementsList->item(i);
-            auto id = item->data(ROLE_ID).toInt();
-            auto pageElement = item->data(ROLE_ELEMENT).value<PageElement*>();
+    AppSettings::SetPageDirty(false);
+}
 
-            QString typeName;
-            switch (pageElement->elementType())
-            {
-            case PageElement::ElementType::Gif:
-            {
-                typeName = TYPE_GIF;
-                break;
-            }
-            case PageElement::ElementType::Text:
-            {
-                typeName = TYPE_TEXT;
-                break;
-            }
-            default:
-                assert(false);
-            }
+// the modifications journaled by a session that didn't end properly
+void MainWindow::recoverPage()
+{
+    finishSaving();
 
-            auto definition = emptyArray();
-            definition[DefType] = typeName;
-            definition[DefId] = id;
-            definition[DefName] = item->text();
-            element.append(definition);
+    QByteArray contents;
+    QString filename;
+    AutosaveJournal::Snapshot saved;
+    bool recovered = false;
 
-            for (auto eventName : pageElement->activeEvents())
+    if (journal.hasRecovery())
+    {
+        auto name = journal.recoveryFilename();
+        auto btn = QMessageBox::question(this, "Unsaved modifications", QString("The editor has not been closed properly, do you want to recover the unsaved modifications of %1?").arg(name.isEmpty() ? "the new page" : QString("'%1'").arg(name)), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+        if (btn == QMessageBox::Yes)
+        {
+            recovered = journal.recover(contents, filename, saved);
+            if (!recovered)
             {
-                auto eventLine = pageElementToJSON(pageElement, eventName);
-                element.append(eventLine);
+                QMessageBox::warning(this, "An error has occured", "The unsaved modifications could not be recovered, the page has been modified since.");
             }
         }
+    }
 
-        while (element.size() < 21)
-        {
-            element.push_back(emptyArray());
-        }
+    // starts the journal over
+    newPage();
 
-        data.append(element);
-    }
+    if (recovered)
+    {
+        openedFilename = filename;
+        loadPage(contents);
 
-    object["data"] = data;
+        // journaled again, on top of what is saved
+        journal.reset(openedFilename, saved);
+        journal.setPage(snapshotPage());
+        AppSettings::SetPageDirty();
+    }
+}
 
+void MainWindow::savePage()
+{
     if (openedFilename.isEmpty())
     {
         openedFilename = QFileDialog::getSaveFileName(this, "Save page", QString(), "Hypnospace pages (*.hsp)");
@@ -303,17 +307,76 @@ void MainWindow::savePage()
         }
     }
 
-    QFile f(openedFilename);
-    if (f.open(QFile::WriteOnly))
+    // the file is only written again once the previous save is done,
+    // with the modifications made in the meantime
+    if (saveWatcher.isRunning())
     {
-        f.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
-        f.close();
+        saveRequested = true;
+        return;
+    }
 
-        AppSettings::SetPageDirty(false);
+    // the last edit is journaled before the save
+    if (captureScheduled) captureEdit();
+
+    // written into a temporary file renamed over the page, on a worker thread
+    journal.beginSave();
+    savingFilename = openedFilename;
+    savingRevision = AppSettings::GetPageRevision();
+    savingSnapshot = snapshotPage();
+    saveWatcher.setFuture(QtConcurrent::run([filename = openedFilename, elements = savingSnapshot]() {
+        QSaveFile f(filename);
+        if (!f.open(QIODevice::WriteOnly)) return false;
+
+        if (!HspWriter::Write(&f, elements))
+        {
+            f.cancelWriting();
+            return false;
+        }
+        return f.commit();
+    }));
+}
+
+void MainWindow::pageSaved()
+{
+    if (savingFilename.isEmpty() || saveWatcher.isRunning()) return;
+
+    auto filename = savingFilename;
+    auto snapshot = savingSnapshot;
+    savingFilename.clear();
+    savingSnapshot.clear();
+
+    if (saveWatcher.result())
+    {
+        // edits made during the save aren't in the file
+        if (AppSettings::GetPageRevision() == savingRevision)
+        {
+            AppSettings::SetPageDirty(false);
+        }
+        journal.saved(filename, snapshot);
+        ui->statusbar->showMessage(QString("Page saved into '%1'").arg(filename), 3000);
     }
     else
     {
-        QMessageBox::critical(this, "Error whilst saving", QString("Could not write the current page into '%1'.").arg(openedFilename));
+        journal.saveFailed();
+        QMessageBox::critical(this, "Error whilst saving", QString("Could not write the current page into '%1'.").arg(filename));
+    }
+
+    if (saveRequested)
+    {
+        saveRequested = false;
+        savePage();
+    }
+}
+
+// the saves must be done before the page is replaced or closed: a page
+// being saved isn't dirty anymore, and the journal must start from the
+// file of the page it journals
+void MainWindow::finishSaving()
+{
+    while (saveWatcher.isRunning() || !savingFilename.isEmpty())
+    {
+        saveWatcher.waitForFinished();
+        pageSaved();
     }
 }
 
@@ -342,13 +405,54 @@ void MainWindow::refresh()
 {
     auto paths = AppSettings::GetSearchPaths();
 
+    AssetIndex::Rebuild(paths);
+
     fontDatabase.clear();
     for (auto path : paths)
     {
         fontDatabase.load(path + "/images/fonts");
     }
 
+    // assets may have changed on disk
+    FrameCache::Clear();
+    Text::ClearLineCache();
+
     settings->refresh();
+
+    assetWatcher.watch(paths);
+
+    // for the next start
+    AssetManifest::Save(true);
+}
+
+void MainWindow::applyAssetChanges(QStringList changedPaths)
+{
+    auto paths = AppSettings::GetSearchPaths();
+
+    // only the changed folders are listed again
+    AssetIndex::Rebuild(paths);
+    FrameCache::Invalidate(changedPaths);
+
+    bool fontsChanged = std::any_of(changedPaths.begin(), changedPaths.end(), [](const QString & path) {
+        return path.contains("/images/fonts");
+    });
+    if (fontsChanged)
+    {
+        fontDatabase.clear();
+        for (auto path : paths)
+        {
+            fontDatabase.load(path + "/images/fonts");
+        }
+        Text::ClearLineCache();
+    }
+
+    settings->refreshAssets(changedPaths);
+
+    // new folders need to be watched too
+    assetWatcher.watch(paths);
+
+    // only the changed folders have been used, the others are kept
+    AssetManifest::Save(false);
 }
 
 QGraphicsItem * MainWindow::createElement(QString type, QJsonArray definition, QStringList eventData)
@@ -359,7 +463,7 @@ QGraphicsItem * MainWindow::createElement(QString type, QJsonArray definition, Q
     if (id == 0)
     {
         auto keys = pageElements.keys();
-        id = *std::max_element(keys.begin(), keys.end()) + 10;
+        id = (keys.isEmpty() ? 0 : *std::max_element(keys.begin(), keys.end())) + 10;
     }
     auto name = definition[2].toString();
     auto item = new QListWidgetItem(name);
@@ -391,6 +495,8 @@ void MainWindow::clearEverything()
         settings->select(id);
     });
     connect(settings, &PageSettings::selectedNameChanged, webpage, &Page::setSelectedName);
+    // a new name doesn't modify any row, it is journaled with its element
+    connect(settings, &PageSettings::selectedNameChanged, this, &MainWindow::scheduleCapture);
     connect(settings, &PageSettings::pageTitleChanged, webpage, &Page::setTitle);
     connect(settings, &PageSettings::pageOwnerChanged, webpage, &Page::setOwner);
     connect(settings, &PageSettings::pageDescriptionChanged, webpage, &Page::setDescription);
@@ -409,6 +515,10 @@ void MainWindow::clearEverything()
     connect(settings, &PageSettings::webpageEventDeactivated, [&](QString name) {
         webpage->clearEvent(name);
     });
+    connect(webpage, &Page::repaintedPixels, [&](qint64 pixels) {
+        repaintedPixelsLabel->setText(QString("%1 repainted pixels/s").arg(pixels));
+    });
+    webpage->setDirtyRectsEnabled(ui->action_Partial_Repaints->isChecked());
 
     webpage->move(0, 0);
     webpage->show();
@@ -420,22 +530,44 @@ void MainWindow::parseJSON(QByteArray data)
 {
     clearEverything();
 
-    auto doc = QJsonDocument::fromJson(data);
-    auto obj = doc.object();
-    auto pageData = obj["data"].toArray();
+    undoStack.clear();
+    watchedWebpage = WatchedRow();
+    watchedElement = WatchedRow();
+
+    QElapsedTimer timer;
+    timer.start();
+    // an element parses in less than a millisecond, summed in nanoseconds
+    QElapsedTimer parsingTimer;
+    qint64 parsingNanoseconds = 0;
+
     webpage->setSceneRect(area->rect());
 
-    for (auto line : pageData)
+    // the elements only store their properties until they are all created
+    QVector<PageElement*> loadedElements;
+    PageElement::SetBulkLoading(true);
+
+    // the page is read one element at a time, straight from the bytes
+    HspReader reader(data);
+    HspReader::Element line;
+    while (true)
     {
-        auto eventList = line.toArray();
-        auto definition = eventList[0].toArray();
-        auto type = definition.first().toString();
+        parsingTimer.start();
+        bool hasLine = reader.readElement(line);
+        parsingNanoseconds += parsingTimer.nsecsElapsed();
+        if (!hasLine) break;
+
+        auto & type = line.type;
+        auto definition = QJsonArray { line.type, line.id, line.name };
 
         PageElement * currentPageElement = nullptr;
 
-        for (int i = 1; i < eventList.size(); i++)
+        for (int i = 1; i <= line.events.size(); i++)
         {
-            auto eventData = eventList[i].toVariant().toStringList();
+            auto eventData = line.events[i - 1];
+            if (eventData.isEmpty())
+            {
+                break;
+            }
             eventData[0] = getRealEventName(eventData[0]);
             if (eventData.first().size() == 0)
             {
@@ -464,15 +596,49 @@ void MainWindow::parseJSON(QByteArray data)
             webpage->setEvent(EVENT_DEFAULT);
             updateSettingsFromPage(webpage);
         }
-        else
+        else if (currentPageElement)
         {
-            currentPageElement->setEvent(EVENT_DEFAULT);
-            currentPageElement->refresh();
-            updateCurrentPageElement(currentPageElement);
+            loadedElements.append(currentPageElement);
         }
     }
 
+    PageElement::SetBulkLoading(false);
+    auto parsingTime = parsingNanoseconds / 1000000;
+    auto elementsTime = timer.restart() - parsingTime;
+
+    if (reader.hasError())
+    {
+        QMessageBox::warning(this, "Damaged page", QString("The page is damaged, only its first %1 elements have been loaded.").arg(loadedElements.size()));
+    }
+
+    PageLoader::DecodeAssets(loadedElements);
+    auto decodingTime = timer.restart();
+
+    // one decode, one recolor and one render per element
+    for (auto element : loadedElements)
+    {
+        element->setEvent(EVENT_DEFAULT);
+        element->refresh();
+    }
+
+    auto assetsTime = timer.restart();
+
+    if (loadedElements.size())
+    {
+        updateCurrentPageElement(loadedElements.last());
+    }
     updateZOrder();
+
+    auto interfaceTime = timer.elapsed();
+
+    ui->statusbar->showMessage(QString("Page loaded in %1 ms (parsing %2 ms, %3 elements %4 ms, decoding %5 ms, assets %6 ms, interface %7 ms)")
+                               .arg(parsingTime + elementsTime + decodingTime + assetsTime + interfaceTime)
+                               .arg(parsingTime)
+                               .arg(loadedElements.size())
+                               .arg(elementsTime)
+                               .arg(decodingTime)
+                               .arg(assetsTime)
+                               .arg(interfaceTime), 10000);
 }
 
 QGraphicsItem * MainWindow::addElement(QString type, QStringList arguments, PageElement * pageElement)
@@ -483,154 +649,22 @@ QGraphicsItem * MainWindow::addElement(QString type, QStringList arguments, Page
     {
         settings->webpageEventsList->setEventActive(arguments[WebEvent], true);
 
-        webpage->setEvent(arguments[WebEvent]);
-        webpage->setBackground(arguments[WebBGImage]);
-        webpage->setLineCount(arguments[WebHeight].toInt());
-
-        webpage->setBackgroundColor(intToColor(arguments[WebBGColor].toInt()));
-
-        webpage->setTitle(arguments[WebTitle]);
+        PageLoader::SetWebpageEvent(webpage, arguments);
         setWindowTitle(webpage->title());
 
-        webpage->setOwner(arguments[WebUsername]);
-        webpage->setMusic(arguments[WebMusic]);
-        webpage->setDescription(arguments[WebDescriptionAndTags]);
-        webpage->setPageCursor(arguments[WebMouseFX].toInt());
-        webpage->setPageStyle(arguments[WebPageStyle].toInt());
-        webpage->setHomePage(arguments[WebUserHOME].toInt() != 0);
-        webpage->setOnLoadScript(arguments[WebOnLoadScript]);
-
         updateSettingsFromPage(webpage);
     }
     else if (type == TYPE_TEXT)
     {
-        settings->elementsEventsList->setEventActive(arguments[WebEvent], true);
-
-        auto x = arguments[TextX].toInt();
-        auto y = arguments[TextY].toInt();
-        auto width = arguments[TextWidth].toInt();
-        auto caseTag = arguments[TextCaseTag];
-        auto string = arguments[TextString];
-        auto color = arguments[TextColor].toInt();
-        auto font = arguments[TextFont];
-        auto style = arguments[TextStyle];
-        auto align = arguments[TextAlign].toInt();
-        auto script = arguments[TextLinkOrScript];
-        auto law = arguments[TextLawBroken].toInt();
-        auto animation = arguments[TextAnimation].toInt();
-        auto animationSpeed = arguments[TextAnimSpeed].toInt();
-        auto fadeColor = arguments[TextColorFadeTo].toInt();
-        auto fadeSpeed = arguments[TextColorFadeSpeed].toInt();
-        auto noContent = arguments[TextNoContent].toInt() != 0;
-
-        auto text = pageElement ? static_cast<Text*>(pageElement) : new Text;
-        text->setEvent(arguments[WebEvent]);
-        text->setAlign(align);
-        text->setHSPosition(x, y);
-        text->setWidth(width);
-        text->setFontSize(QString(style[0]).toInt());
-        text->setFontBold(style[1] == 'b');
-        text->setFont(font.toLower());
-        text->setAnimation(animation);
-        text->setAnimationSpeed(animationSpeed);
-        text->setCaseTag(caseTag);
-        text->setBrokenLaw(law);
-        text->setNoContent(noContent);
-        text->setScript(script);
-
-        text->setFontColor(intToColor(color));
-        text->setFade(intToColor(fadeColor), fadeSpeed);
-
-        text->setString(string);
-
-        returnedElement = text;
+        settings->elementsEventsList->setEventActive(arguments[TextEvent], true);
+
+        returnedElement = PageLoader::SetTextEvent(static_cast<Text*>(pageElement), arguments);
     }
     else if (type == TYPE_GIF)
     {
-        settings->elementsEventsList->setEventActive(arguments[WebEvent], true);
-
-        auto x = arguments[GifX].toInt();
-        auto y = arguments[GifY].toInt();
-        auto color = arguments[GifHSL].split(',');
-        auto caseTag = arguments[GifCaseTag];
-        auto image = arguments[GifNameOf];
-        auto scale = arguments[GifScale].toDouble();
-        auto rotation = arguments[GifRotation].toInt();
-        auto mirrored = arguments[GifMirror].toInt() != 0;
-        auto flipped = arguments[GifFlip].toInt() != 0;
-        auto script = arguments[GifLinkOrScript];
-        auto law = arguments[GifLawBroken].toInt();
-        auto animFlipX = arguments[GifAnimFlipX].toInt();
-        auto animFlipY = arguments[GifAnimFlipY].toInt();
-        auto animFade = arguments[GifAnimFade].toInt();
-        auto animTurn = arguments[GifAnimTurn].toInt();
-        auto animTurnSpeed = arguments[GifAnimTurnSpeed].toInt();
-        auto offset = arguments[GifOffset].toInt();
-        auto sync = arguments[GifSync].toInt() != 0;
-        auto animMouseOver = arguments[GifAnimMouseOver].toInt();
-
-        auto gif = pageElement ? static_cast<Gif*>(pageElement) : new Gif;
-
-        gif->setEvent(arguments[WebEvent]);
-        gif->setNameOf(image);
-        gif->setFrameOffset(offset);
-        gif->setHSScale(scale);
-        gif->setHSRotation(rotation);
-        gif->mirror(mirrored);
-        gif->flip(flipped);
-        gif->setCaseTag(caseTag);
-        gif->setBrokenLaw(law);
-        gif->setScript(script);
-
-        if (animFlipX == -1)
-        {
-            gif->set3DFlipX(false);
-            gif->set3DFlipXSpeed(0);
-        }
-        else
-        {
-            gif->set3DFlipX(true);
-            gif->set3DFlipXSpeed(animFlipX);
-        }
+        settings->elementsEventsList->setEventActive(arguments[GifEvent], true);
 
-        if (animFlipY == -1)
-        {
-            gif->set3DFlipY(false);
-            gif->set3DFlipYSpeed(0);
-        }
-        else
-        {
-            gif->set3DFlipY(true);
-            gif->set3DFlipYSpeed(animFlipY);
-        }
-
-        if (animFade == -1)
-        {
-            gif->setFade(false);
-            gif->setFadeSpeed(0);
-        }
-        else
-        {
-            gif->setFade(true);
-            gif->setFadeSpeed(animFade);
-        }
-
-        gif->setSwingOrSpin(animTurn);
-        gif->setSwingOrSpinSpeed(animTurnSpeed);
-        gif->setSync(sync);
-        gif->setGifAnimation(animMouseOver);
-
-        gif->setPosition(x, y);
-
-        if (color.size() == 3)
-        {
-            auto h = color[0].toInt();
-            auto s = color[1].toInt();
-            auto l = color[2].toInt();
-            gif->setHSL(h, s, l);
-        }
-
-        returnedElement = gif;
+        returnedElement = PageLoader::SetGifEvent(static_cast<Gif*>(pageElement), arguments);
     }
 
     if (returnedElement && !pageElement)
@@ -641,97 +675,170 @@ QGraphicsItem * MainWindow::addElement(QString type, QStringList arguments, Page
     return returnedElement;
 }
 
-QJsonArray MainWindow::gifToJson(Gif * gif, QString eventName)
-{
-    gif->setEvent(eventName);
-
-    QJsonArray array = emptyArray();
-
-    array[GifEvent] = eventName.toUpper();
-    array[GifX] = QString::number(gif->HSX());
-    array[GifY] = QString::number(gif->HSY());
-    array[GifHSL] = QString("%1,%2,%3").arg(gif->H()).arg(gif->S()).arg(gif->L());
-    array[GifCaseTag] = gif->caseTag();
-    array[GifNameOf] = gif->nameOf();
-    array[GifScale] = QString::number(gif->HSScale(), 'f', 2);
-    array[GifRotation] = QString::number(gif->HSRotation());
-    array[GifMirror] = gif->mirrored() ? "1" : "0";
-    array[GifFlip] = gif->flipped() ? "1" : "0";
-    array[GifLinkOrScript] = gif->script();
-    array[GifLawBroken] = QString::number(gif->brokenLaw());
-    array[GifAnimFlipX] = QString::number(gif->flip3DX() ? gif->flip3DXSpeed() : -1);
-    array[GifAnimFlipY] = QString::number(gif->flip3DY() ? gif->flip3DYSpeed() : -1);
-    array[GifAnimFade] = QString::number(gif->fade() ? gif->fadeSpeed() : -1);
-    array[GifAnimTurn] = QString::number(gif->swingOrSpin());
-    array[GifAnimTurnSpeed] = QString::number(gif->swingOrSpinSpeed());
-    array[GifFPS] = "0"; // unused
-    array[GifOffset] = QString::number(gif->offsetFrame());
-    array[GifSync] = gif->sync() ? "1" : "0";
-    array[GifAnimMouseOver] = QString::number(gif->gifAnimation());
-
-    return array;
-}
-
-QJsonArray MainWindow::textToJson(Text * text, QString eventName)
-{
-    text->setEvent(eventName);
-
-    QJsonArray array = emptyArray();
-
-    array[TextEvent] = eventName.toUpper();
-    array[TextX] = QString::number(text->xoffset());
-    array[TextY] = QString::number(text->HSY());
-    array[TextWidth] = QString::number(text->width());
-    array[TextCaseTag] = text->caseTag();
-    array[TextString] = text->string().replace("\n", "/n");
-    array[TextColor] = QString::number(colorToInt(text->fontColor()));
-    array[TextFont] = text->fontName();
-    array[TextStyle] = QString("%1%2").arg(text->fontSize()).arg(text->fontBold() ? 'b' : 'n');
-    array[TextAlign] = QString::number(text->align());
-    array[TextLinkOrScript] = text->script();
-    array[TextLawBroken] = QString::number(text->brokenLaw());
-    array[TextAnimation] = QString::number(static_cast<int>(text->animation()));
-    array[TextAnimSpeed] = QString::number(text->animationSpeed());
-    array[TextColorFadeTo] = QString::number(colorToInt(text->fadeColor()));
-    array[TextColorFadeSpeed] = QString::number(text->fadeSpeed());
-    array[TextNoContent] = text->noContent() ? "1" : "0";
-
-    return array;
+// the events are read directly, the elements stay on their current event
+QVector<HspWriter::Element> MainWindow::snapshotPage()
+{
+    QVector<HspWriter::Element> elements;
+    elements.reserve(settings->ui->elementsList->count() + 1);
+
+    elements.append(webpageSnapshot());
+
+    for (auto i = 0; i < settings->ui->elementsList->count(); i++)
+    {
+        elements.append(elementSnapshot(settings->ui->elementsList->item(i)));
+    }
+
+    return elements;
 }
 
-QJsonArray MainWindow::emptyArray()
+HspWriter::Element MainWindow::webpageSnapshot()
 {
-    return QJsonArray {QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString()};
+    HspWriter::Element page;
+    page.type = TYPE_WEBPAGE;
+    page.id = -1;
+    auto webpageEvents = settings->ui->webpageEventsList;
+    for (int row = 0; row < webpageEvents->count(); row++)
+    {
+        page.rows.append(webpageToStringList(webpageEvents->item(row)->text()));
+    }
+
+    return page;
 }
 
-QJsonArray MainWindow::pageElementToJSON(PageElement * pageElement, QString eventName)
+HspWriter::Element MainWindow::elementSnapshot(QListWidgetItem * item)
 {
-    QJsonArray array;
+    auto pageElement = item->data(ROLE_ELEMENT).value<PageElement*>();
 
+    HspWriter::Element element;
     switch (pageElement->elementType())
     {
     case PageElement::ElementType::Gif:
-        array = gifToJson(dynamic_cast<Gif*>(pageElement), eventName);
+    {
+        element.type = TYPE_GIF;
         break;
+    }
     case PageElement::ElementType::Text:
-        array = textToJson(dynamic_cast<Text*>(pageElement), eventName);
+    {
+        element.type = TYPE_TEXT;
         break;
+    }
     default:
         assert(false);
     }
 
-    return array;
+    element.id = item->data(ROLE_ID).toInt();
+    element.name = item->text();
+    for (auto eventName : pageElement->activeEvents())
+    {
+        element.rows.append(pageElementToStringList(pageElement, eventName));
+    }
+
+    return element;
 }
 
-QStringList MainWindow::pageElementToStringList(PageElement * pageElement, QString eventName)
+QStringList MainWindow::webpageToStringList(QString eventName)
+{
+    auto ev = eventData(webpage->events, eventName, webpage->currentEvent);
+
+    QStringList list = HspWriter::EmptyRow();
+
+    list[WebEvent] = eventName.toUpper();
+    list[WebTitle] = ev.title;
+    list[WebUsername] = webpage->username;
+    list[WebHeight] = QString::number(ev.linesCount);
+    list[WebMusic] = ev.music;
+    list[WebBGImage] = ev.background;
+    list[WebMouseFX] = QString::number(ev.cursor);
+    list[WebBGColor] = QString::number(colorToInt(ev.backgroundColor));
+    list[WebDescriptionAndTags] = ev.descriptionAndTags;
+    list[WebPageStyle] = QString::number(ev.pageStyle);
+    list[WebUserHOME] = webpage->isUserHomePage ? "1" : "0";
+    list[WebOnLoadScript] = ev.onLoadScript;
+
+    return list;
+}
+
+QStringList MainWindow::gifToStringList(Gif * gif, QString eventName)
 {
-    QJsonArray array = pageElementToJSON(pageElement, eventName);
+    auto ev = eventData(gif->events, eventName, gif->currentEvent);
+    auto pageEv = eventData(gif->pageEvents, eventName, gif->currentEvent);
+
+    QStringList list = HspWriter::EmptyRow();
+
+    list[GifEvent] = eventName.toUpper();
+    list[GifX] = QString::number(ev.x);
+    list[GifY] = QString::number(ev.y);
+    list[GifHSL] = QString("%1,%2,%3").arg(ev.H).arg(ev.S).arg(ev.L);
+    list[GifCaseTag] = pageEv.caseTag;
+    list[GifNameOf] = ev.nameOf;
+    list[GifScale] = QString::number(ev.scale, 'f', 2);
+    list[GifRotation] = QString::number(ev.angle);
+    list[GifMirror] = ev.mirrored ? "1" : "0";
+    list[GifFlip] = ev.flipped ? "1" : "0";
+    list[GifLinkOrScript] = pageEv.script;
+    list[GifLawBroken] = QString::number(pageEv.brokenLaw);
+    list[GifAnimFlipX] = QString::number(ev.flip3DX ? ev.flip3DXSpeed : -1);
+    list[GifAnimFlipY] = QString::number(ev.flip3DY ? ev.flip3DYSpeed : -1);
+    list[GifAnimFade] = QString::number(ev.fade ? ev.fadeSpeed : -1);
+    list[GifAnimTurn] = QString::number(ev.swingOrSpin);
+    list[GifAnimTurnSpeed] = QString::number(ev.swingOrSpinSpeed);
+    list[GifFPS] = "0"; // unused
+    list[GifOffset] = QString::number(ev.offsetFrame);
+    list[GifSync] = ev.sync ? "1" : "0";
+    list[GifAnimMouseOver] = QString::number(ev.gifAnimation);
 
+    return list;
+}
+
+QStringList MainWindow::textToStringList(Text * text, QString eventName)
+{
+    auto ev = eventData(text->events, eventName, text->currentEvent);
+    auto pageEv = eventData(text->pageEvents, eventName, text->currentEvent);
+
+    QStringList list = HspWriter::EmptyRow();
+
+    list[TextEvent] = eventName.toUpper();
+    list[TextX] = QString::number(ev.xoffset);
+    list[TextY] = QString::number(ev.y);
+    list[TextWidth] = QString::number(ev.width);
+    list[TextCaseTag] = pageEv.caseTag;
+    list[TextString] = ev.string.replace("\n", "/n");
+    list[TextColor] = QString::number(colorToInt(ev.fontColor));
+    list[TextFont] = ev.fontName;
+    list[TextStyle] = QString("%1%2").arg(ev.fontSize).arg(ev.fontBold ? 'b' : 'n');
+    list[TextAlign] = QString::number(ev.align);
+    list[TextLinkOrScript] = pageEv.script;
+    list[TextLawBroken] = QString::number(pageEv.brokenLaw);
+    list[TextAnimation] = QString::number(static_cast<int>(ev.animation));
+    list[TextAnimSpeed] = QString::number(ev.animationSpeed);
+    list[TextColorFadeTo] = QString::number(colorToInt(ev.fadeColor));
+    list[TextColorFadeSpeed] = QString::number(ev.fadeSpeed);
+    list[TextNoContent] = ev.noContent ? "1" : "0";
+
+    return list;
+}
+
+QJsonArray MainWindow::emptyArray()
+{
+    return QJsonArray {QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString(), QString()};
+}
+
+QStringList MainWindow::pageElementToStringList(PageElement * pageElement, QString eventName)
+{
     QStringList list;
-    for (auto value : array)
+
+    switch (pageElement->elementType())
     {
-        list += value.toString();
+    case PageElement::ElementType::Gif:
+        list = gifToStringList(dynamic_cast<Gif*>(pageElement), eventName);
+        break;
+    case PageElement::ElementType::Text:
+        list = textToStringList(dynamic_cast<Text*>(pageElement), eventName);
+        break;
+    default:
+        assert(false);
     }
+
     return list;
 }
 
@@ -758,15 +865,7 @@ void MainWindow::updateCurrentPageElement(PageElement * pageElement)
 
 QString MainWindow::getRealEventName(QString name)
 {
-    for (auto event : settings->realEventsNames)
-    {
-        if (event.compare(name, Qt::CaseInsensitive) == 0)
-        {
-            return event;
-        }
-    }
-
-    return name;
+    return PageLoader::EventName(settings->realEventsNames, name);
 }
 
 void MainWindow::updateZOrder()
@@ -803,14 +902,15 @@ void MainWindow::duplicateElement(QString name, PageElement * pageElement)
 
     auto activeEvents = pageElement->activeEvents();
 
+    QGraphicsItem * createdElement = nullptr;
     PageElement * currentPageElement = nullptr;
     for (int i = 1; auto eventName : activeEvents)
     {
         auto eventData = pageElementToStringList(pageElement, eventName);
-        if (i == 1)
+        if (i++ == 1)
         {
-            auto elem = createElement(type, definition, eventData);
-            currentPageElement = dynamic_cast<PageElement*>(elem);
+            createdElement = createElement(type, definition, eventData);
+            currentPageElement = dynamic_cast<PageElement*>(createdElement);
         }
         else
         {
@@ -819,4 +919,307 @@ void MainWindow::duplicateElement(QString name, PageElement * pageElement)
     }
 
     updateZOrder();
+
+    if (createdElement)
+    {
+        recordCreation(createdElement->data(ROLE_ID).toInt());
+    }
+}
+
+void MainWindow::deleteElement(int id)
+{
+    auto item = elementItem(id);
+    if (!item) return;
+
+    UndoStack::Command command;
+    command.type = UndoStack::Command::Type::Delete;
+    command.id = id;
+    command.element = elementSnapshot(item);
+    command.row = settings->ui->elementsList->row(item);
+    undoStack.push(command);
+
+    removeElement(id);
+}
+
+void MainWindow::undo()
+{
+    // an edit made right before is a command of its own
+    if (captureScheduled) captureEdit();
+    if (!undoStack.canUndo()) return;
+
+    applyCommand(undoStack.undo(), true);
+}
+
+void MainWindow::redo()
+{
+    if (captureScheduled) captureEdit();
+    if (!undoStack.canRedo()) return;
+
+    applyCommand(undoStack.redo(), false);
+}
+
+void MainWindow::setUndoBudget()
+{
+    bool ok = false;
+    auto megabytes = QInputDialog::getInt(this, "Undo memory", "Memory kept for undoing modifications (MiB):", AppSettings::GetUndoBudget() / (1024 * 1024), 1, 1024, 1, &ok);
+    if (ok)
+    {
+        AppSettings::SetUndoBudget(qint64(megabytes) * 1024 * 1024);
+        undoStack.setBudget(AppSettings::GetUndoBudget());
+    }
+}
+
+void MainWindow::scheduleCapture()
+{
+    if (captureScheduled) return;
+
+    captureScheduled = true;
+    QTimer::singleShot(0, this, &MainWindow::captureEdit);
+}
+
+// the edits are found by comparing the rows of the current event of the
+// webpage and of the selected element with the ones seen last time, so an
+// edit only costs a row whatever the size of the page.
+void MainWindow::captureEdit()
+{
+    captureScheduled = false;
+    if (PageElement::IsBulkLoading()) return;
+
+    QStringList webpageEvents;
+    for (int row = 0; row < settings->ui->webpageEventsList->count(); row++)
+    {
+        webpageEvents.append(settings->ui->webpageEventsList->item(row)->text());
+    }
+    captureRow(watchedWebpage, -1, webpage->currentEvent, webpageToStringList(webpage->currentEvent), QString(), webpageEvents);
+
+    auto item = settings->ui->elementsList->currentItem();
+    auto pageElement = item ? item->data(ROLE_ELEMENT).value<PageElement*>() : nullptr;
+    if (pageElement)
+    {
+        auto event = pageElement->currentEvent;
+        captureRow(watchedElement, item->data(ROLE_ID).toInt(), event, pageElementToStringList(pageElement, event), item->text(), pageElement->activeEvents());
+    }
+    else
+    {
+        watchedElement = WatchedRow();
+    }
+}
+
+void MainWindow::captureRow(WatchedRow & watched, int id, QString event, QStringList row, QString name, QStringList events)
+{
+    // an event added, removed or moved, or a new name: the element is journaled whole
+    bool restructured = !applyingCommand && watched.id == id && (watched.name != name || watched.events != events);
+    if (restructured)
+    {
+        if (id == -1)
+        {
+            journal.setElement(webpageSnapshot());
+        }
+        else if (auto item = elementItem(id))
+        {
+            journal.setElement(elementSnapshot(item));
+        }
+    }
+
+    if (!applyingCommand && watched.id == id && watched.event == event && watched.row.size() == row.size())
+    {
+        UndoStack::Command command;
+        command.id = id;
+        command.event = event;
+
+        // dragging an element only changes its position
+        bool moved = id != -1;
+        for (int column = 1; column < row.size(); column++)
+        {
+            if (row[column] != watched.row[column])
+            {
+                command.changes.append({ column, watched.row[column], row[column] });
+                moved = moved && (column == GifX || column == GifY);
+
+                if (!restructured)
+                {
+                    journal.setValue(id, event, column, row[column]);
+                }
+            }
+        }
+
+        if (!command.changes.isEmpty())
+        {
+            command.type = moved ? UndoStack::Command::Type::Move : UndoStack::Command::Type::Property;
+            undoStack.push(command);
+        }
+    }
+
+    watched = WatchedRow { id, event, row, name, events };
+}
+
+void MainWindow::recordCreation(int id)
+{
+    auto item = elementItem(id);
+    if (!item) return;
+
+    UndoStack::Command command;
+    command.type = UndoStack::Command::Type::Create;
+    command.id = id;
+    command.element = elementSnapshot(item);
+    command.row = settings->ui->elementsList->row(item);
+    undoStack.push(command);
+
+    journal.setElement(command.element);
+    journalOrder();
+}
+
+void MainWindow::journalOrder()
+{
+    QVector<qint32> order { -1 };
+    for (int i = 0; i < settings->ui->elementsList->count(); i++)
+    {
+        order.append(settings->ui->elementsList->item(i)->data(ROLE_ID).toInt());
+    }
+    journal.setOrder(order);
+}
+
+void MainWindow::applyCommand(const UndoStack::Command & command, bool undo)
+{
+    applyingCommand = true;
+
+    switch (command.type)
+    {
+    case UndoStack::Command::Type::Property:
+    case UndoStack::Command::Type::Move:
+        applyChanges(command, undo);
+        break;
+    case UndoStack::Command::Type::Create:
+        if (undo) removeElement(command.id);
+        else restoreElement(command.element, command.row);
+        break;
+    case UndoStack::Command::Type::Delete:
+        if (undo) restoreElement(command.element, command.row);
+        else removeElement(command.id);
+        break;
+    }
+
+    // the watched rows now match the page
+    captureEdit();
+    applyingCommand = false;
+
+    AppSettings::SetPageDirty();
+}
+
+void MainWindow::applyChanges(const UndoStack::Command & command, bool undo)
+{
+    if (command.id == -1)
+    {
+        if (!webpage->events.contains(command.event)) return;
+
+        auto row = webpageToStringList(command.event);
+        for (auto & change : command.changes)
+        {
+            row[change.column] = undo ? change.before : change.after;
+            journal.setValue(command.id, command.event, change.column, row[change.column]);
+        }
+        row[WebEvent] = command.event;
+        addElement(TYPE_WEBPAGE, row);
+
+        auto events = settings->ui->webpageEventsList->findItems(command.event, Qt::MatchExactly);
+        if (events.size())
+        {
+            settings->ui->webpageEventsList->setCurrentItem(events.first());
+        }
+        return;
+    }
+
+    auto item = elementItem(command.id);
+    if (!item) return;
+    auto pageElement = item->data(ROLE_ELEMENT).value<PageElement*>();
+    if (!pageElement->activeEvents().contains(command.event)) return;
+
+    auto row = pageElementToStringList(pageElement, command.event);
+    for (auto & change : command.changes)
+    {
+        row[change.column] = undo ? change.before : change.after;
+        journal.setValue(command.id, command.event, change.column, row[change.column]);
+    }
+    row[GifEvent] = command.event;
+
+    auto type = pageElement->elementType() == PageElement::ElementType::Gif ? TYPE_GIF : TYPE_TEXT;
+    addElement(type, row, pageElement);
+    pageElement->refresh();
+
+    // shows what changed
+    settings->ui->elementsList->setCurrentItem(item, QItemSelectionModel::Clear | QItemSelectionModel::SelectCurrent);
+    auto events = settings->ui->elementsEventsList->findItems(command.event, Qt::MatchExactly);
+    if (events.size())
+    {
+        settings->ui->elementsEventsList->setCurrentItem(events.first());
+    }
+    updateCurrentPageElement(pageElement);
+}
+
+void MainWindow::restoreElement(const HspWriter::Element & element, int row)
+{
+    PageElement * pageElement = nullptr;
+    for (int i = 0; i < element.rows.size(); i++)
+    {
+        auto eventData = element.rows[i];
+        eventData[0] = getRealEventName(eventData[0]);
+        if (i == 0)
+        {
+            auto definition = QJsonArray { element.type, element.id, element.name };
+            pageElement = dynamic_cast<PageElement*>(createElement(element.type, definition, eventData));
+        }
+        else
+        {
+            addElement(element.type, eventData, pageElement);
+        }
+    }
+    if (!pageElement) return;
+
+    pageElement->setEvent(EVENT_DEFAULT);
+    pageElement->refresh();
+
+    // back to its place in the elements list
+    auto list = settings->ui->elementsList;
+    auto item = list->takeItem(list->count() - 1);
+    list->insertItem(std::min(row, list->count()), item);
+    updateZOrder();
+
+    journal.setElement(element);
+    journalOrder();
+
+    list->setCurrentItem(item, QItemSelectionModel::Clear | QItemSelectionModel::SelectCurrent);
+}
+
+void MainWindow::removeElement(int id)
+{
+    auto item = elementItem(id);
+    if (!item) return;
+
+    auto pageElement = item->data(ROLE_ELEMENT).value<PageElement*>();
+    auto graphics = dynamic_cast<QGraphicsItem*>(pageElement);
+    if (graphics && graphics->scene())
+    {
+        graphics->scene()->removeItem(graphics);
+    }
+    pageElement->deleteLater();
+
+    delete settings->ui->elementsList->takeItem(settings->ui->elementsList->row(item));
+    pageElements.remove(id);
+    journal.removeElement(id);
+
+    AppSettings::SetPageDirty();
+}
+
+QListWidgetItem * MainWindow::elementItem(int id)
+{
+    for (int i = 0; i < settings->ui->elementsList->count(); i++)
+    {
+        auto item = settings->ui->elementsList->item(i);
+        if (item->data(ROLE_ID).toInt() == id)
+        {
+            return item;
+        }
+    }
+
+    return nullptr;
 }
@@ -3,12 +3,20 @@
 
 #include <QMainWindow>
 #include <QJsonArray>
+#include <QFutureWatcher>
 #include "page.h"
 #include "pagesettings.h"
 #include "fontdatabase.h"
+#include "animationclock.h"
+#include "assetwatcher.h"
+#include "hspwriter.h"
+#include "autosavejournal.h"
+#include "undostack.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
+class QLabel;
+class QListWidgetItem;
 QT_END_NAMESPACE
 
 class MainWindow : public QMainWindow
@@ -27,34 +35,81 @@ private slots:
     void openPage();
     void savePage();
     void savePageAs();
+    void pageSaved();
     void openModsWindow();
     void refresh();
+    void applyAssetChanges(QStringList changedPaths);
     QGraphicsItem * createElement(QString type, QJsonArray definition, QStringList eventData);
     void updateZOrder();
     void duplicateElement(QString name, PageElement * pageElement);
+    void deleteElement(int id);
+    void undo();
+    void redo();
+    void setUndoBudget();
+    void scheduleCapture();
+    void captureEdit();
 
 private:
     void clearEverything();
+    void loadPage(QByteArray contents);
+    void finishSaving();
+    void recoverPage();
     void parseJSON(QByteArray data);
     QGraphicsItem * addElement(QString type, QStringList arguments, PageElement * pageElement = nullptr);
-    QJsonArray gifToJson(Gif * gif, QString eventName);
-    QJsonArray textToJson(Text * text, QString eventName);
+    QVector<HspWriter::Element> snapshotPage();
+    HspWriter::Element webpageSnapshot();
+    HspWriter::Element elementSnapshot(QListWidgetItem * item);
+    QStringList webpageToStringList(QString eventName);
+    QStringList gifToStringList(Gif * gif, QString eventName);
+    QStringList textToStringList(Text * text, QString eventName);
     QJsonArray emptyArray();
-    QJsonArray pageElementToJSON(PageElement * pageElement, QString eventName);
     QStringList pageElementToStringList(PageElement * pageElement, QString eventName);
     void updateSettingsFromPage(Page * webpage);
     void updateCurrentPageElement(PageElement * pageElement);
 
     QString getRealEventName(QString name);
 
+    struct WatchedRow {
+        int id = -2;
+        QString event;
+        QStringList row;
+        // what is journaled whole when it changes
+        QString name;
+        QStringList events;
+    };
+
+    void captureRow(WatchedRow & watched, int id, QString event, QStringList row, QString name, QStringList events);
+    void recordCreation(int id);
+    void journalOrder();
+    void applyCommand(const UndoStack::Command & command, bool undo);
+    void applyChanges(const UndoStack::Command & command, bool undo);
+    void restoreElement(const HspWriter::Element & element, int row);
+    void removeElement(int id);
+    QListWidgetItem * elementItem(int id);
+
     friend class PageSettings;
     QHash<int, QGraphicsItem*> pageElements;
     Ui::MainWindow * ui = nullptr;
     Page * webpage = nullptr;
     PageSettings * settings = nullptr;
     FontDatabase fontDatabase;
+    AnimationClock animationClock;
+    AssetWatcher assetWatcher;
     QWidget * area = nullptr;
+    QLabel * repaintedPixelsLabel = nullptr;
     QString openedFilename;
+    QFutureWatcher<bool> saveWatcher;
+    QString savingFilename;
+    quint64 savingRevision = 0;
+    // saved again once the running save is done
+    bool saveRequested = false;
+    AutosaveJournal::Snapshot savingSnapshot;
+    AutosaveJournal journal;
+    UndoStack undoStack;
+    WatchedRow watchedWebpage;
+    WatchedRow watchedElement;
+    bool captureScheduled = false;
+    bool applyingCommand = false;
 };
 
 #endif // MAINWINDOW_H
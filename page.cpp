@@ -1,11 +1,14 @@
 #include "page.h"
 #include "globals.h"
 #include "appsettings.h"
+#include "assetindex.h"
+#include "animationclock.h"
 #include <QPainter>
 #include <QPushButton>
 #include <QWheelEvent>
 #include <QScrollBar>
 #include <QGraphicsItem>
+#include <QPaintEvent>
 
 constexpr int LINE_HEIGHT = 32;
 
@@ -14,11 +17,10 @@ Page::Page(QWidget * parent)
 {
     setFixedWidth(300 * ZOOM);
     scale(ZOOM, ZOOM);
-    startTimer(60);
 
     setCacheMode(QGraphicsView::CacheBackground);
     setOptimizationFlags(QGraphicsView::DontAdjustForAntialiasing);
-    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     setResizeAnchor(QGraphicsView::NoAnchor);
     setTransformationAnchor(QGraphicsView::NoAnchor);
     setAlignment(Qt::AlignLeft | Qt::AlignTop);
@@ -27,6 +29,8 @@ Page::Page(QWidget * parent)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 
     scene = new QGraphicsScene(this);
+    // few items that move a lot, the BSP tree costs more than it saves
+    scene->setItemIndexMethod(QGraphicsScene::NoIndex);
     connect(scene, &QGraphicsScene::selectionChanged, [&]() {
         auto items = scene->selectedItems();
         if (items.size())
@@ -39,9 +43,20 @@ Page::Page(QWidget * parent)
             selectedItem = nullptr;
             selectedName.clear();
         }
+        // the selection frame is drawn outside of the items
+        viewport()->update();
     });
     setScene(scene);
 
+    // one repaint for all the elements animated during this tick
+    connect(AnimationClock::Get(), &AnimationClock::ticked, this, [this](float, const QVector<QGraphicsItem*> & changedItems) {
+        animationTicked(changedItems);
+    });
+    connect(AnimationClock::Get(), &AnimationClock::unregistered, this, [this](QGraphicsItem * item) {
+        lastRects.remove(item);
+    });
+    paintedPixelsTimer.start();
+
     parent->installEventFilter(this);
 }
 
@@ -49,12 +64,15 @@ Page::~Page()
 {
     // crash without
     scene->disconnect();
+    // the items are deleted with the scene, after the members of the page
+    AnimationClock::Get()->disconnect(this);
 }
 
 void Page::setLineCount(int lineCount)
 {
     setFixedHeight(lineCount * LINE_HEIGHT * ZOOM);
     update();
+    updateVisibleRect();
 
     events[currentEvent].linesCount = lineCount;
     AppSettings::SetPageDirty();
@@ -68,18 +86,13 @@ void Page::setBackground(QString image)
 
     if (!image.isEmpty())
     {
-        auto searchPaths = AppSettings::GetSearchPaths();
-        for (auto path : searchPaths)
+        auto img = AssetIndex::Resolve("images/bgs/" + image);
+        if (!img.isEmpty())
         {
-            auto img = path + "/images/bgs/" + image;
-            if (QFile(img).exists())
-            {
-                auto pix = QPixmap(img);
-                CHECK_DATA(!pix.isNull(), QString("Unable to load background '%1'.").arg(image))
-                evData.background = image;
-                setBackgroundBrush(pix);
-                break;
-            }
+            auto pix = QPixmap(img);
+            CHECK_DATA(!pix.isNull(), QString("Unable to load background '%1'.").arg(image))
+            evData.background = image;
+            setBackgroundBrush(pix);
         }
     }
 
@@ -146,6 +159,10 @@ bool Page::eventFilter(QObject * watched, QEvent * event)
         wheelEvent(wheel);
         return true;
     }
+    else if (event->type() == QEvent::Resize)
+    {
+        updateVisibleRect();
+    }
 
     return QGraphicsView::eventFilter(watched, event);
 }
@@ -263,6 +280,100 @@ void Page::setPageCursor(int newCursor)
     AppSettings::SetPageDirty();
 }
 
+void Page::setDirtyRectsEnabled(bool enabled)
+{
+    useDirtyRects = enabled;
+    lastRects.clear();
+    setViewportUpdateMode(enabled ? QGraphicsView::SmartViewportUpdate : QGraphicsView::FullViewportUpdate);
+    viewport()->update();
+}
+
+bool Page::dirtyRectsEnabled() const
+{
+    return useDirtyRects;
+}
+
+QImage Page::renderPage(qreal scale) const
+{
+    QRectF pageRect(0, 0, PAGE_WIDTH, events.value(currentEvent).linesCount * LINE_HEIGHT);
+
+    QImage image((pageRect.size() * scale).toSize(), QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+    {
+        return image;
+    }
+    image.fill(Qt::black);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+    // tiled from the top of the page, like in the view
+    painter.fillRect(pageRect, backgroundBrush());
+    scene->render(&painter, pageRect, pageRect);
+
+    return image;
+}
+
+void Page::animationTicked(const QVector<QGraphicsItem*> & changedItems)
+{
+    // still reported when nothing is repainted
+    reportPaintedPixels();
+
+    if (!useDirtyRects)
+    {
+        viewport()->update();
+        return;
+    }
+
+    QRegion dirty;
+    for (auto item : changedItems)
+    {
+        // removed from the page, it starts again from its own rect if added back
+        if (item->scene() != scene)
+        {
+            lastRects.remove(item);
+            continue;
+        }
+
+        // the item must be repainted where it was and where it is now
+        auto rect = item->sceneBoundingRect();
+        auto & lastRect = lastRects[item];
+        auto sceneRect = lastRect.isNull() ? rect : lastRect.united(rect);
+        lastRect = rect;
+
+        if (item == selectedItem)
+        {
+            // includes the selection frame and its label
+            sceneRect.adjust(-4, -12, 4, 4);
+        }
+
+        dirty += mapFromScene(sceneRect).boundingRect().adjusted(-1, -1, 1, 1);
+    }
+
+    if (!dirty.isEmpty())
+    {
+        viewport()->update(dirty);
+    }
+}
+
+void Page::paintEvent(QPaintEvent * event)
+{
+    for (auto & rect : event->region())
+    {
+        paintedPixels += qint64(rect.width()) * rect.height();
+    }
+
+    QGraphicsView::paintEvent(event);
+}
+
+void Page::reportPaintedPixels()
+{
+    if (paintedPixelsTimer.elapsed() >= 1000)
+    {
+        emit repaintedPixels(paintedPixels * 1000 / paintedPixelsTimer.restart());
+        paintedPixels = 0;
+    }
+}
+
 void Page::drawForeground(QPainter * painter, const QRectF & rect)
 {
     Q_UNUSED(rect)
@@ -303,6 +414,7 @@ void Page::wheelEvent(QWheelEvent * event)
         {
             topLine--;
             move(0, topLine * -LINE_HEIGHT * ZOOM);
+            updateVisibleRect();
         }
     }
     else if (event->angleDelta().y() < 0)
@@ -311,6 +423,7 @@ void Page::wheelEvent(QWheelEvent * event)
         {
             topLine++;
             move(0, topLine * -LINE_HEIGHT * ZOOM);
+            updateVisibleRect();
         }
     }
 
@@ -352,6 +465,8 @@ void Page::mouseMoveEvent(QMouseEvent * event)
         auto pos = event->localPos();
         auto diff = (pos - lastMousePosition) / 2;
         selectedItem->moveBy(diff.x(), diff.y());
+        // the selection frame follows the item
+        viewport()->update();
 
         auto pageElement = dynamic_cast<PageElement*>(selectedItem);
         if (pageElement->elementType() == PageElement::ElementType::Text)
@@ -365,3 +480,11 @@ void Page::mouseMoveEvent(QMouseEvent * event)
         AppSettings::SetPageDirty();
     }
 }
+
+void Page::updateVisibleRect()
+{
+    // the page is scrolled by moving it inside its parent, so only
+    // the lines from topLine to the bottom of the parent can be seen.
+    auto visibleHeight = parentWidget()->height() / ZOOM;
+    AnimationClock::SetVisibleRect(QRectF(0, topLine * LINE_HEIGHT, PAGE_WIDTH, visibleHeight));
+}
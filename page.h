@@ -4,6 +4,9 @@
 #include <QWidget>
 #include <QGraphicsView>
 #include <QMap>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QImage>
 #include "pageelement.h"
 
 constexpr int ZOOM = 2;
@@ -33,8 +36,15 @@ public:
     int cursor();
     int pageStyle();
 
+    void setDirtyRectsEnabled(bool enabled);
+    bool dirtyRectsEnabled() const;
+
+    // the whole page, not only its visible lines, without the selection
+    QImage renderPage(qreal scale = 1) const;
+
 signals:
     void selected(int id);
+    void repaintedPixels(qint64 pixelsPerSecond);
 
 public slots:
     void setEvent(QString name);
@@ -53,6 +63,7 @@ public slots:
     void clearEvent(QString name);
 
 protected:
+    void paintEvent(QPaintEvent * event) override;
     void drawForeground(QPainter * painter, const QRectF & rect) override;
     void wheelEvent(QWheelEvent *event) override;
     void mousePressEvent(QMouseEvent * event) override;
@@ -61,6 +72,10 @@ protected:
     void mouseMoveEvent(QMouseEvent * event) override;
 
 private:
+    void updateVisibleRect();
+    void animationTicked(const QVector<QGraphicsItem*> & changedItems);
+    void reportPaintedPixels();
+
     friend class MainWindow;
 
     struct EventData {
@@ -86,6 +101,12 @@ private:
     QGraphicsItem * selectedItem = nullptr;
     QString selectedName;
     QPointF lastMousePosition;
+
+    // partial repaints of the animated elements
+    bool useDirtyRects = true;
+    QHash<QGraphicsItem*, QRectF> lastRects;
+    qint64 paintedPixels = 0;
+    QElapsedTimer paintedPixelsTimer;
 };
 
 #endif // PAGE_H
@@ -1,8 +1,15 @@
 #include "pageelement.h"
 #include "appsettings.h"
+#include "animationclock.h"
 
 PageElement::PageElement()
 {
+    AnimationClock::Register(this);
+}
+
+PageElement::~PageElement()
+{
+    AnimationClock::Unregister(this);
 }
 
 void PageElement::setEvent(QString name)
@@ -26,6 +33,16 @@ void PageElement::clearEvent(QString name)
     pageEvents.remove(name);
 }
 
+void PageElement::SetBulkLoading(bool loading)
+{
+    bulkLoading = loading;
+}
+
+bool PageElement::IsBulkLoading()
+{
+    return bulkLoading;
+}
+
 QStringList PageElement::activeEvents() const
 {
     return orderedEvents;
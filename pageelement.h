@@ -15,12 +15,21 @@ public:
     };
 
     PageElement();
-    virtual ~PageElement() = default;
+    virtual ~PageElement();
 
     virtual void setEvent(QString name);
     virtual void clearEvent(QString name);
     virtual ElementType elementType() const = 0;
     virtual void refresh() = 0;
+    // called with the asset folders and files that changed on disk
+    virtual void assetsChanged(const QStringList & changedPaths) = 0;
+    // returns true when the element looks different afterwards
+    virtual bool animate(float dt, bool visible) = 0;
+
+    // while a page is loaded, setters only store their values and
+    // each element is materialized once by refresh() at the end.
+    static void SetBulkLoading(bool loading);
+    static bool IsBulkLoading();
 
     QStringList activeEvents() const;
     void moveActiveEvent(int from, int to);
@@ -37,6 +46,8 @@ protected:
     QString currentEvent;
 
 private:
+    friend class MainWindow;
+
     struct PageEventData {
         QString caseTag;
         int brokenLaw = -1;
@@ -45,6 +56,8 @@ private:
 
     QMap<QString, PageEventData> pageEvents;
     QStringList orderedEvents;
+
+    static inline bool bulkLoading = false;
 };
 
 #endif // PAGEELEMENT_H
@@ -0,0 +1,311 @@
+#include "pageloader.h"
+#include "page.h"
+#include "gif.h"
+#include "text.h"
+#include "framecache.h"
+#include "hspreader.h"
+#include "globals.h"
+#include <QSet>
+#include <QtConcurrent>
+
+static QColor intToColor(int color)
+{
+    if (color < 0) return QColor(QColor::Invalid);
+
+    int r = (color >> 0) & 0xFF;
+    int g = (color >> 8) & 0xFF;
+    int b = (color >> 16) & 0xFF;
+    return QColor(r, g, b);
+}
+
+void PageLoader::SetWebpageEvent(Page * webpage, const QStringList & arguments)
+{
+    webpage->setEvent(arguments[WebEvent]);
+    webpage->setBackground(arguments[WebBGImage]);
+    webpage->setLineCount(arguments[WebHeight].toInt());
+
+    webpage->setBackgroundColor(intToColor(arguments[WebBGColor].toInt()));
+
+    webpage->setTitle(arguments[WebTitle]);
+
+    webpage->setOwner(arguments[WebUsername]);
+    webpage->setMusic(arguments[WebMusic]);
+    webpage->setDescription(arguments[WebDescriptionAndTags]);
+    webpage->setPageCursor(arguments[WebMouseFX].toInt());
+    webpage->setPageStyle(arguments[WebPageStyle].toInt());
+    webpage->setHomePage(arguments[WebUserHOME].toInt() != 0);
+    webpage->setOnLoadScript(arguments[WebOnLoadScript]);
+}
+
+Text * PageLoader::SetTextEvent(Text * text, const QStringList & arguments)
+{
+    auto x = arguments[TextX].toInt();
+    auto y = arguments[TextY].toInt();
+    auto width = arguments[TextWidth].toInt();
+    auto caseTag = arguments[TextCaseTag];
+    auto string = arguments[TextString];
+    auto color = arguments[TextColor].toInt();
+    auto font = arguments[TextFont];
+    auto style = arguments[TextStyle];
+    auto align = arguments[TextAlign].toInt();
+    auto script = arguments[TextLinkOrScript];
+    auto law = arguments[TextLawBroken].toInt();
+    auto animation = arguments[TextAnimation].toInt();
+    auto animationSpeed = arguments[TextAnimSpeed].toInt();
+    auto fadeColor = arguments[TextColorFadeTo].toInt();
+    auto fadeSpeed = arguments[TextColorFadeSpeed].toInt();
+    auto noContent = arguments[TextNoContent].toInt() != 0;
+
+    if (!text)
+    {
+        text = new Text;
+    }
+
+    text->setEvent(arguments[TextEvent]);
+    text->setAlign(align);
+    text->setHSPosition(x, y);
+    text->setWidth(width);
+    text->setFontSize(QString(style[0]).toInt());
+    text->setFontBold(style[1] == 'b');
+    text->setFont(font.toLower());
+    text->setAnimation(animation);
+    text->setAnimationSpeed(animationSpeed);
+    text->setCaseTag(caseTag);
+    text->setBrokenLaw(law);
+    text->setNoContent(noContent);
+    text->setScript(script);
+
+    text->setFontColor(intToColor(color));
+    text->setFade(intToColor(fadeColor), fadeSpeed);
+
+    text->setString(string);
+
+    return text;
+}
+
+Gif * PageLoader::SetGifEvent(Gif * gif, const QStringList & arguments)
+{
+    auto x = arguments[GifX].toInt();
+    auto y = arguments[GifY].toInt();
+    auto color = arguments[GifHSL].split(',');
+    auto caseTag = arguments[GifCaseTag];
+    auto image = arguments[GifNameOf];
+    auto scale = arguments[GifScale].toDouble();
+    auto rotation = arguments[GifRotation].toInt();
+    auto mirrored = arguments[GifMirror].toInt() != 0;
+    auto flipped = arguments[GifFlip].toInt() != 0;
+    auto script = arguments[GifLinkOrScript];
+    auto law = arguments[GifLawBroken].toInt();
+    auto animFlipX = arguments[GifAnimFlipX].toInt();
+    auto animFlipY = arguments[GifAnimFlipY].toInt();
+    auto animFade = arguments[GifAnimFade].toInt();
+    auto animTurn = arguments[GifAnimTurn].toInt();
+    auto animTurnSpeed = arguments[GifAnimTurnSpeed].toInt();
+    auto offset = arguments[GifOffset].toInt();
+    auto sync = arguments[GifSync].toInt() != 0;
+    auto animMouseOver = arguments[GifAnimMouseOver].toInt();
+
+    if (!gif)
+    {
+        gif = new Gif;
+    }
+
+    gif->setEvent(arguments[GifEvent]);
+    gif->setNameOf(image);
+    gif->setFrameOffset(offset);
+    gif->setHSScale(scale);
+    gif->setHSRotation(rotation);
+    gif->mirror(mirrored);
+    gif->flip(flipped);
+    gif->setCaseTag(caseTag);
+    gif->setBrokenLaw(law);
+    gif->setScript(script);
+
+    if (animFlipX == -1)
+    {
+        gif->set3DFlipX(false);
+        gif->set3DFlipXSpeed(0);
+    }
+    else
+    {
+        gif->set3DFlipX(true);
+        gif->set3DFlipXSpeed(animFlipX);
+    }
+
+    if (animFlipY == -1)
+    {
+        gif->set3DFlipY(false);
+        gif->set3DFlipYSpeed(0);
+    }
+    else
+    {
+        gif->set3DFlipY(true);
+        gif->set3DFlipYSpeed(animFlipY);
+    }
+
+    if (animFade == -1)
+    {
+        gif->setFade(false);
+        gif->setFadeSpeed(0);
+    }
+    else
+    {
+        gif->setFade(true);
+        gif->setFadeSpeed(animFade);
+    }
+
+    gif->setSwingOrSpin(animTurn);
+    gif->setSwingOrSpinSpeed(animTurnSpeed);
+    gif->setSync(sync);
+    gif->setGifAnimation(animMouseOver);
+
+    gif->setPosition(x, y);
+
+    if (color.size() == 3)
+    {
+        auto h = color[0].toInt();
+        auto s = color[1].toInt();
+        auto l = color[2].toInt();
+        gif->setHSL(h, s, l);
+    }
+
+    return gif;
+}
+
+void PageLoader::DecodeAssets(QVector<PageElement*> elements)
+{
+    QVector<Gif::Asset> defaultAssets;
+    QVector<Gif::Asset> otherAssets;
+    for (auto element : elements)
+    {
+        if (element->elementType() != PageElement::ElementType::Gif) continue;
+
+        auto gifAssets = static_cast<Gif*>(element)->assets();
+        if (gifAssets.isEmpty()) continue;
+
+        defaultAssets.append(gifAssets.takeLast());
+        otherAssets += gifAssets;
+    }
+
+    QVector<Gif::Asset> assets;
+    QSet<QString> sources;
+    QStringList files;
+    for (auto & asset : defaultAssets + otherAssets)
+    {
+        if (asset.source.isEmpty() || sources.contains(asset.source) || FrameCache::ContainsDecoded(asset.source)) continue;
+
+        sources.insert(asset.source);
+        assets.append(asset);
+        files += asset.files;
+    }
+
+    if (assets.isEmpty()) return;
+
+    // QImage can be decoded on any thread, QPixmap only on this one
+    auto images = QtConcurrent::mapped(files, [](const QString & file) {
+        return QImage(file);
+    }).results();
+
+    QHash<QString, QPixmap> pixmaps;
+    for (int i = 0; i < files.size(); i++)
+    {
+        pixmaps.insert(files[i], QPixmap::fromImage(images[i]));
+    }
+
+    // the assets of the default events are inserted last,
+    // the least likely to be evicted from the cache.
+    for (int i = assets.size() - 1; i >= 0; i--)
+    {
+        auto & asset = assets[i];
+        QVector<QPixmap> frames;
+        for (auto & file : asset.files)
+        {
+            frames.append(pixmaps.value(file));
+        }
+        FrameCache::InsertDecoded(asset.source, frames, asset.speed);
+    }
+}
+
+QVector<PageElement*> PageLoader::Load(Page * webpage, const QByteArray & data, const QStringList & eventsNames, bool * damaged)
+{
+    QVector<PageElement*> elements;
+
+    // the elements only store their properties until they are all created
+    PageElement::SetBulkLoading(true);
+
+    HspReader reader(data);
+    HspReader::Element line;
+    while (reader.readElement(line))
+    {
+        PageElement * element = nullptr;
+
+        for (auto eventData : line.events)
+        {
+            if (eventData.isEmpty())
+            {
+                break;
+            }
+            eventData[0] = EventName(eventsNames, eventData[0]);
+            if (eventData.first().size() == 0)
+            {
+                break;
+            }
+
+            if (line.type == TYPE_WEBPAGE)
+            {
+                SetWebpageEvent(webpage, eventData);
+            }
+            else if (line.type == TYPE_TEXT)
+            {
+                element = SetTextEvent(static_cast<Text*>(element), eventData);
+            }
+            else if (line.type == TYPE_GIF)
+            {
+                element = SetGifEvent(static_cast<Gif*>(element), eventData);
+            }
+        }
+
+        if (line.type == TYPE_WEBPAGE)
+        {
+            webpage->setEvent(EVENT_DEFAULT);
+        }
+        else if (element)
+        {
+            auto item = dynamic_cast<QGraphicsItem*>(element);
+            item->setZValue(elements.size() * -1);
+            webpage->addElement(item);
+            elements.append(element);
+        }
+    }
+
+    PageElement::SetBulkLoading(false);
+
+    if (damaged)
+    {
+        *damaged = reader.hasError();
+    }
+
+    DecodeAssets(elements);
+
+    // one decode, one recolor and one render per element
+    for (auto element : elements)
+    {
+        element->setEvent(EVENT_DEFAULT);
+        element->refresh();
+    }
+
+    return elements;
+}
+
+QString PageLoader::EventName(const QStringList & eventsNames, QString name)
+{
+    for (auto & event : eventsNames)
+    {
+        if (event.compare(name, Qt::CaseInsensitive) == 0)
+        {
+            return event;
+        }
+    }
+
+    return name;
+}
@@ -0,0 +1,33 @@
+#ifndef PAGELOADER_H
+#define PAGELOADER_H
+
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+
+class Page;
+class Gif;
+class Text;
+class PageElement;
+
+// applies the events read from a .hsp page to the webpage and its elements,
+// for the editor and for the tools that load pages without it.
+class PageLoader
+{
+public:
+    static void SetWebpageEvent(Page * webpage, const QStringList & arguments);
+    // creates the element when it is null
+    static Text * SetTextEvent(Text * text, const QStringList & arguments);
+    static Gif * SetGifEvent(Gif * gif, const QStringList & arguments);
+
+    // every image used by any event of any element, decoded only once
+    static void DecodeAssets(QVector<PageElement*> elements);
+
+    // the whole page on its default event, like MainWindow::parseJSON without
+    // the interface. the elements are returned from the top one.
+    static QVector<PageElement*> Load(Page * webpage, const QByteArray & data, const QStringList & eventsNames, bool * damaged = nullptr);
+    // the name of misc/events.txt, whatever its case in the page
+    static QString EventName(const QStringList & eventsNames, QString name);
+};
+
+#endif // PAGELOADER_H
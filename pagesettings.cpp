@@ -2,6 +2,7 @@
 #include "ui_pagesettings.h"
 #include "ui_tabbedimages.h"
 #include "appsettings.h"
+#include "assetmanifest.h"
 #include "pageelement.h"
 #include "gif.h"
 #include "text.h"
@@ -166,27 +167,8 @@ PageSettings::PageSettings(MainWindow * parent) :
     connect(ui->deleteBtn, &QPushButton::clicked, [&]() {
         auto item = ui->elementsList->currentItem();
         if (!item) return;
-        auto txt = item->data(ROLE_ELEMENT).value<Text*>();
-        auto gif = item->data(ROLE_ELEMENT).value<Gif*>();
 
-        QGraphicsItem * graphics = nullptr;
-        if (txt)
-        {
-            graphics = txt;
-            txt->deleteLater();
-        }
-        else if (gif)
-        {
-            graphics = gif;
-            gif->deleteLater();
-        }
-
-        if (graphics)
-        {
-            graphics->scene()->removeItem(graphics);
-        }
-
-        delete ui->elementsList->takeItem(ui->elementsList->row(item));
+        emit deleteElement(item->data(ROLE_ID).toInt());
     });
 
     connect(ui->addTextButton, &QPushButton::clicked, [&]() {
@@ -1132,6 +1114,57 @@ void PageSettings::refresh()
     refreshEvents();
 }
 
+void PageSettings::refreshAssets(QStringList changedPaths)
+{
+    // elements reload only what they use, they are drawn again but the
+    // page doesn't change: nothing is marked dirty, journaled or undoable
+    AppSettings::SuspendPageModifications(true);
+    for (int i = 0; i < ui->elementsList->count(); i++)
+    {
+        auto item = ui->elementsList->item(i);
+        if (!item) continue;
+        auto pageElement = item->data(ROLE_ELEMENT).value<PageElement*>();
+
+        pageElement->assetsChanged(changedPaths);
+    }
+    AppSettings::SuspendPageModifications(false);
+
+    auto changed = [&](QStringList folders) {
+        for (auto & path : changedPaths)
+        {
+            for (auto & folder : folders)
+            {
+                if (path.contains(folder)) return true;
+            }
+        }
+        return false;
+    };
+
+    // and only the lists showing the changed folders are rebuilt
+    if (changed({ "/images/gifs", "/images/static", "/images/shapes", "/images/wordart" }))
+    {
+        refreshGifsList();
+    }
+    if (changed({ "/images/bgs" }))
+    {
+        ui->imageSlider->refresh();
+    }
+    if (changed({ "/audio/music", "/audio/hsm/pageloops" }))
+    {
+        refreshMusicList();
+    }
+    if (changed({ "/misc" }))
+    {
+        refreshUsers();
+    }
+
+    auto items = ui->elementsList->selectedItems();
+    if (items.size() == 1)
+    {
+        updateProperties(items.first());
+    }
+}
+
 void PageSettings::refreshGifsList()
 {
     ui->tabbedImages->clear();
@@ -1140,7 +1173,7 @@ void PageSettings::refreshGifsList()
     auto paths = AppSettings::GetSearchPaths();
     for (auto path : paths)
     {
-        auto folders = QDir(path + "/images/gifs/").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        auto folders = AssetManifest::EntryList(path + "/images/gifs/", QStringList(), QDir::Dirs);
         for (auto folder : folders)
         {
             ui->tabbedImages->addImage(TabbedImages::Type::Gif, folder);
@@ -1149,7 +1182,7 @@ void PageSettings::refreshGifsList()
         auto type = TabbedImages::Type::Static;
         for (auto subFolder : subFolders)
         {
-            auto files = QDir(path + subFolder).entryList(QStringList() << "*.png", QDir::Files);
+            auto files = AssetManifest::EntryList(path + subFolder, QStringList() << "*.png", QDir::Files);
             for (auto f : files)
             {
                 ui->tabbedImages->addImage(type, f.chopped(4));
@@ -1158,7 +1191,7 @@ void PageSettings::refreshGifsList()
             type = TabbedImages::Type::Shape;
         }
 
-        auto fonts = QDir(path + "/images/wordart/").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        auto fonts = AssetManifest::EntryList(path + "/images/wordart/", QStringList(), QDir::Dirs);
         for (auto folder : fonts)
         {
             ui->tabbedImages->addImage(TabbedImages::Type::Wordart, folder);
@@ -1178,44 +1211,45 @@ void PageSettings::refreshMusicList()
     {
         QDir dir(path + "/audio/music");
 
-        for (auto txt : dir.entryList(QStringList() << "*.txt", QDir::Files, QDir::Name))
+        for (auto txt : AssetManifest::EntryList(dir.path(), QStringList() << "*.txt", QDir::Files))
         {
             if (doneMusics.contains(txt)) continue;
             doneMusics.append(txt);
 
-            QFile file(dir.absoluteFilePath(txt));
-            if (file.open(QFile::ReadOnly))
-            {
-                auto data = file.readAll().split('|');
+            // title and artist
+            auto data = AssetManifest::Parsed(dir.absoluteFilePath(txt), [](QByteArray content) {
+                auto fields = content.split('|');
+                return QVariant(QStringList { fields.value(0), fields.value(1) });
+            }).toStringList();
 
-                auto formattedName = QString("\"%1\" by %2").arg(QString(data[0])).arg(QString(data[1]));
+            if (data.size())
+            {
+                auto formattedName = QString("\"%1\" by %2").arg(data[0]).arg(data[1]);
                 ui->musicComboBox->addItem(formattedName, "audio\\music\\" + txt.replace(".txt", ".ogg"));
-
-                file.close();
             }
         }
 
         dir.setPath(path + "/audio/hsm/pageloops");
 
-        for (auto hsm : dir.entryList(QStringList() << "*.hsm", QDir::Files, QDir::Name))
+        for (auto hsm : AssetManifest::EntryList(dir.path(), QStringList() << "*.hsm", QDir::Files))
         {
             if (doneMusics.contains(hsm)) continue;
             doneMusics.append(hsm);
 
-            QFile file(dir.absoluteFilePath(hsm));
-            if (file.open(QFile::ReadOnly))
-            {
-                auto data = file.readAll();
-                auto json = QJsonDocument::fromJson(data);
+            // title and artist
+            auto data = AssetManifest::Parsed(dir.absoluteFilePath(hsm), [](QByteArray content) {
+                auto json = QJsonDocument::fromJson(content);
                 auto obj = json.object();
                 auto jsonData = obj["data"].toArray();
                 auto jsonBox = jsonData[0].toArray();
                 auto jsonLine = jsonBox[0].toArray();
+                return QVariant(QStringList { jsonLine[0].toString(), jsonLine[1].toString() });
+            }).toStringList();
 
-                auto formattedName = QString("\"%1\" by %2").arg(jsonLine[0].toString()).arg(jsonLine[1].toString());
+            if (data.size())
+            {
+                auto formattedName = QString("\"%1\" by %2").arg(data[0]).arg(data[1]);
                 ui->musicComboBox->addItem(formattedName, "audio\\hsm\\pageloops\\" + hsm);
-
-                file.close();
             }
         }
     }
@@ -1239,23 +1273,23 @@ void PageSettings::refreshUsers()
     auto paths = AppSettings::GetSearchPaths();
     for (auto path : paths)
     {
-        QFile file(path + "/misc/chardata.hsd");
-        if (file.open(QFile::ReadOnly))
-        {
-            auto data = file.readAll();
-            auto json = QJsonDocument::fromJson(data);
+        auto usernames = AssetManifest::Parsed(path + "/misc/chardata.hsd", [](QByteArray content) {
+            QStringList usernames;
+            auto json = QJsonDocument::fromJson(content);
             auto obj = json.object();
             auto jsonData = obj["data"].toArray();
             for (auto jsonUserData : jsonData)
             {
                 auto jsonBox = jsonUserData.toArray();
                 auto jsonLine = jsonBox[0].toArray();
-                auto username = jsonLine[0].toString();
-
-                uniqueNames.insert(username);
+                usernames.append(jsonLine[0].toString());
             }
+            return QVariant(usernames);
+        }).toStringList();
 
-            file.close();
+        for (auto & username : usernames)
+        {
+            uniqueNames.insert(username);
         }
     }
 
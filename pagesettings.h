@@ -46,6 +46,7 @@ signals:
     void backgroundChanged(QString image);
     void lineCountChanged(int count);
     void duplicateElement(QString name, PageElement * pageElement);
+    void deleteElement(int id);
     void musicChanged(QString music);
     void cursorChanged(int cursor);
     void pageStyleChanged(int style);
@@ -72,6 +73,7 @@ private:
     void setBackgroundColor(QWidget * widget, QColor color);
 
     void refresh();
+    void refreshAssets(QStringList changedPaths);
     void refreshGifsList();
     void refreshMusicList();
     void refreshUsers();
@@ -0,0 +1,49 @@
+QT += core gui widgets concurrent
+
+QMAKE_CXXFLAGS += -std=c++2a
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# the pages are loaded and drawn by the sources of the editor
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../animationclock.cpp \
+    ../appsettings.cpp \
+    ../assetindex.cpp \
+    ../assetmanifest.cpp \
+    ../fontdatabase.cpp \
+    ../framecache.cpp \
+    ../gif.cpp \
+    ../hspreader.cpp \
+    ../page.cpp \
+    ../pageelement.cpp \
+    ../pageloader.cpp \
+    ../text.cpp \
+    ../utils.cpp \
+    apngwriter.cpp \
+    batchrenderer.cpp \
+    main.cpp \
+    pagerenderer.cpp
+
+HEADERS += \
+    ../animationclock.h \
+    ../appsettings.h \
+    ../assetindex.h \
+    ../assetmanifest.h \
+    ../fontdatabase.h \
+    ../framecache.h \
+    ../gif.h \
+    ../globals.h \
+    ../hspreader.h \
+    ../page.h \
+    ../pageelement.h \
+    ../pageloader.h \
+    ../text.h \
+    ../utils.h \
+    apngwriter.h \
+    batchrenderer.h \
+    pagerenderer.h
@@ -0,0 +1,178 @@
+#include "apngwriter.h"
+#include <QBuffer>
+#include <QtEndian>
+#include <array>
+
+static void appendUInt32(QByteArray & data, quint32 value)
+{
+    char bytes[4];
+    qToBigEndian(value, bytes);
+    data.append(bytes, 4);
+}
+
+static void appendUInt16(QByteArray & data, quint16 value)
+{
+    char bytes[2];
+    qToBigEndian(value, bytes);
+    data.append(bytes, 2);
+}
+
+ApngWriter::ApngWriter(QIODevice * device, int frameCount, int fps)
+    : device(device)
+    , frameCount(frameCount)
+    , fps(fps)
+{
+}
+
+bool ApngWriter::writeFrame(const QImage & image)
+{
+    if (failed || writtenFrames >= frameCount)
+    {
+        failed = true;
+        return false;
+    }
+
+    // always 8 bits RGBA, whatever the content of the frame
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    if (!image.convertToFormat(QImage::Format_ARGB32).save(&buffer, "PNG"))
+    {
+        failed = true;
+        return false;
+    }
+
+    // the chunks after the signature: length, type, data and CRC
+    auto png = buffer.data();
+    QByteArray imageHeader;
+    QByteArray imageData;
+    int pos = 8;
+    while (pos + 12 <= png.size())
+    {
+        auto length = qFromBigEndian<quint32>(png.constData() + pos);
+        auto type = png.mid(pos + 4, 4);
+        if (length > quint32(png.size() - pos - 12))
+        {
+            break;
+        }
+
+        if (type == "IHDR")
+        {
+            imageHeader = png.mid(pos + 8, length);
+        }
+        else if (type == "IDAT")
+        {
+            imageData.append(png.constData() + pos + 8, length);
+        }
+
+        pos += 12 + length;
+    }
+
+    if (imageHeader.size() != 13 || imageData.isEmpty())
+    {
+        failed = true;
+        return false;
+    }
+
+    if (writtenFrames == 0)
+    {
+        header = imageHeader;
+        device->write("\x89PNG\r\n\x1a\n", 8);
+        writeChunk("IHDR", header);
+
+        QByteArray animationControl;
+        appendUInt32(animationControl, frameCount);
+        // played forever
+        appendUInt32(animationControl, 0);
+        writeChunk("acTL", animationControl);
+    }
+    else if (imageHeader != header)
+    {
+        failed = true;
+        return false;
+    }
+
+    auto width = qFromBigEndian<quint32>(header.constData());
+    auto height = qFromBigEndian<quint32>(header.constData() + 4);
+    writeChunk("fcTL", frameControl(width, height));
+
+    // the first frame is also the image shown without animations
+    if (writtenFrames == 0)
+    {
+        writeChunk("IDAT", imageData);
+    }
+    else
+    {
+        QByteArray frameData;
+        appendUInt32(frameData, sequenceNumber++);
+        frameData += imageData;
+        writeChunk("fdAT", frameData);
+    }
+
+    writtenFrames++;
+    return !failed;
+}
+
+bool ApngWriter::finish()
+{
+    if (writtenFrames > 0)
+    {
+        writeChunk("IEND", QByteArray());
+    }
+
+    return !failed && writtenFrames == frameCount;
+}
+
+void ApngWriter::writeChunk(const char * type, const QByteArray & data)
+{
+    QByteArray chunk;
+    appendUInt32(chunk, data.size());
+    chunk.append(type, 4);
+    chunk.append(data);
+    appendUInt32(chunk, Crc32(chunk.mid(4)));
+
+    if (device->write(chunk) != chunk.size())
+    {
+        failed = true;
+    }
+}
+
+// every frame replaces the whole image for 1/fps second
+QByteArray ApngWriter::frameControl(int width, int height)
+{
+    QByteArray data;
+    appendUInt32(data, sequenceNumber++);
+    appendUInt32(data, width);
+    appendUInt32(data, height);
+    appendUInt32(data, 0);
+    appendUInt32(data, 0);
+    appendUInt16(data, 1);
+    appendUInt16(data, fps);
+    // no disposal, the source replaces the previous frame
+    data.append('\0');
+    data.append('\0');
+    return data;
+}
+
+quint32 ApngWriter::Crc32(const QByteArray & data)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> table;
+        for (quint32 i = 0; i < 256; i++)
+        {
+            quint32 c = i;
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (auto byte : data)
+    {
+        crc = table[(crc ^ quint8(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
@@ -0,0 +1,36 @@
+#ifndef APNGWRITER_H
+#define APNGWRITER_H
+
+#include <QByteArray>
+#include <QImage>
+
+class QIODevice;
+
+// writes the frames of an animated PNG one at a time. every frame is
+// encoded by the PNG writer of Qt, its image data is then moved into the
+// animation, so all the frames must have the size of the first one.
+class ApngWriter
+{
+public:
+    ApngWriter(QIODevice * device, int frameCount, int fps);
+
+    bool writeFrame(const QImage & image);
+    // false if fewer frames than announced have been written
+    bool finish();
+
+private:
+    void writeChunk(const char * type, const QByteArray & data);
+    QByteArray frameControl(int width, int height);
+
+    static quint32 Crc32(const QByteArray & data);
+
+    QIODevice * device;
+    int frameCount;
+    int fps;
+    int writtenFrames = 0;
+    quint32 sequenceNumber = 0;
+    QByteArray header;
+    bool failed = false;
+};
+
+#endif // APNGWRITER_H
@@ -0,0 +1,162 @@
+#include "batchrenderer.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QVariant>
+#include <algorithm>
+
+BatchRenderer::BatchRenderer(QStringList workerArguments, int jobs)
+    : arguments(workerArguments)
+    , maxWorkers(std::max(jobs, 1))
+{
+}
+
+void BatchRenderer::start(QVector<Job> pages)
+{
+    pending = pages;
+    reports.resize(pages.size());
+    next = 0;
+    elapsed.start();
+
+    if (pending.isEmpty())
+    {
+        printSummary();
+        emit finished();
+        return;
+    }
+
+    while (running < maxWorkers && next < pending.size())
+    {
+        startNext();
+    }
+}
+
+int BatchRenderer::failures() const
+{
+    return std::count_if(reports.begin(), reports.end(), [](const Report & report) {
+        return !report.ok;
+    });
+}
+
+void BatchRenderer::startNext()
+{
+    int index = next++;
+    auto & job = pending[index];
+    reports[index].page = job.page;
+
+    auto process = new QProcess(this);
+    // the warnings of Qt go straight to the console
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    auto startTime = elapsed.elapsed();
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=]() {
+        workerFinished(process, index, startTime);
+    });
+    connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        // finished() isn't emitted when the worker can't be started
+        if (error == QProcess::FailedToStart)
+        {
+            workerFinished(process, index, startTime);
+        }
+    });
+
+    running++;
+    process->start(QCoreApplication::applicationFilePath(), arguments + QStringList { "--output", job.outputDirectory, job.page });
+}
+
+void BatchRenderer::workerFinished(QProcess * process, int index, qint64 startTime)
+{
+    auto & report = reports[index];
+    report.processTime = elapsed.elapsed() - startTime;
+
+    // the result is the last line written by the worker
+    auto lines = process->readAllStandardOutput().trimmed().split('\n');
+    auto result = QJsonDocument::fromJson(lines.last()).object();
+
+    if (process->exitStatus() != QProcess::NormalExit || result.isEmpty())
+    {
+        report.error = process->error() == QProcess::FailedToStart ? process->errorString() : "the worker crashed";
+    }
+    else
+    {
+        report.ok = result["ok"].toBool();
+        report.error = result["error"].toString();
+        report.warnings = result["warnings"].toVariant().toStringList();
+        report.elements = result["elements"].toInt();
+        report.events = result["events"].toInt();
+        report.loadTime = result["load"].toVariant().toLongLong();
+        report.renderTime = result["render"].toVariant().toLongLong();
+        report.writeTime = result["write"].toVariant().toLongLong();
+    }
+
+    QTextStream err(stderr);
+    err << QString("[%1/%2] %3 %4\n").arg(index + 1).arg(pending.size()).arg(report.page).arg(report.ok ? "done" : "FAILED: " + report.error);
+    for (auto & warning : report.warnings)
+    {
+        err << "    " << warning << "\n";
+    }
+    err.flush();
+
+    process->deleteLater();
+    running--;
+
+    if (next < pending.size())
+    {
+        startNext();
+    }
+    else if (running == 0)
+    {
+        printSummary();
+        emit finished();
+    }
+}
+
+void BatchRenderer::printSummary()
+{
+    QTextStream out(stdout);
+
+    int nameWidth = 4;
+    for (auto & report : reports)
+    {
+        nameWidth = std::max(nameWidth, report.page.size());
+    }
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+           .arg("page", -nameWidth)
+           .arg("elements", 8)
+           .arg("events", 6)
+           .arg("load ms", 8)
+           .arg("render ms", 9)
+           .arg("write ms", 8)
+           .arg("total ms", 8);
+
+    int events = 0;
+    for (auto & report : reports)
+    {
+        if (!report.ok)
+        {
+            out << QString("%1 failed: %2\n").arg(report.page, -nameWidth).arg(report.error);
+            continue;
+        }
+
+        events += report.events;
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(report.page, -nameWidth)
+               .arg(report.elements, 8)
+               .arg(report.events, 6)
+               .arg(report.loadTime, 8)
+               .arg(report.renderTime, 9)
+               .arg(report.writeTime, 8)
+               .arg(report.processTime, 8);
+    }
+
+    out << QString("%1 pages, %2 events rendered in %3 ms with %4 workers, %5 failed\n")
+           .arg(reports.size())
+           .arg(events)
+           .arg(elapsed.elapsed())
+           .arg(maxWorkers)
+           .arg(failures());
+    out.flush();
+}
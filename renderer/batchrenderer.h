@@ -0,0 +1,57 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QVector>
+
+// renders the pages in worker processes, as many at once as there are
+// cores: the pages and their elements can only live on the main thread.
+class BatchRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Job {
+        QString page;
+        QString outputDirectory;
+    };
+
+    // given to every worker, along with its page and output directory
+    BatchRenderer(QStringList workerArguments, int jobs);
+
+    void start(QVector<Job> pages);
+    int failures() const;
+
+signals:
+    void finished();
+
+private:
+    struct Report {
+        QString page;
+        bool ok = false;
+        QString error;
+        QStringList warnings;
+        int elements = 0;
+        int events = 0;
+        qint64 loadTime = 0;
+        qint64 renderTime = 0;
+        qint64 writeTime = 0;
+        qint64 processTime = 0;
+    };
+
+    void startNext();
+    void workerFinished(QProcess * process, int index, qint64 startTime);
+    void printSummary();
+
+    QStringList arguments;
+    int maxWorkers = 1;
+    int running = 0;
+    int next = 0;
+    QVector<Job> pending;
+    QVector<Report> reports;
+    QElapsedTimer elapsed;
+};
+
+#endif // BATCHRENDERER_H
@@ -0,0 +1,178 @@
+#include "batchrenderer.h"
+#include "pagerenderer.h"
+#include "appsettings.h"
+#include "assetindex.h"
+#include "assetmanifest.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+// renders .hsp pages to PNG files without the editor, one file per event,
+// or the animations of each event with --frames:
+//
+//     PageRenderer [options] <pages or directories...>
+//
+// the directories are searched recursively, and each page is rendered by
+// a worker process started with --worker.
+int main(int argc, char *argv[])
+{
+    // no window is ever shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    QCoreApplication::setApplicationName("PageRenderer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders Hypnospace pages to PNG files, one file or one animation per event.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("pages", "The .hsp pages, or the directories containing them.", "<pages...>");
+
+    QCommandLineOption outputOption({ "o", "output" }, "The directory where the images are written.", "directory", "renders");
+    QCommandLineOption rootOption({ "r", "root" }, "The data directory of the game, the one of the editor by default.", "directory");
+    QCommandLineOption modsOption({ "m", "mods" }, "The mods to enable, separated by commas, the ones of the editor by default.", "mods");
+    QCommandLineOption scaleOption({ "s", "scale" }, "The size of a pixel of the page in the images.", "scale", "1");
+    QCommandLineOption framesOption({ "f", "frames" }, "The number of frames of the animations to capture, 1 for a still image.", "frames", "1");
+    QCommandLineOption fpsOption("fps", "The frames captured per second of animation.", "fps", "60");
+    QCommandLineOption apngOption("apng", "Writes the frames into an animated PNG rather than a numbered PNG each.");
+    QCommandLineOption jobsOption({ "j", "jobs" }, "The number of pages rendered at once.", "jobs", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption workerOption("worker");
+    workerOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOptions({ outputOption, rootOption, modsOption, scaleOption, framesOption, fpsOption, apngOption, jobsOption, workerOption });
+    parser.process(a);
+
+    QTextStream err(stderr);
+
+    // read only, the editor owns the settings
+    AppSettings settings;
+
+    auto root = parser.isSet(rootOption) ? parser.value(rootOption) : AppSettings::GetRootPath();
+    if (root.isEmpty() || !QFileInfo(root).isDir())
+    {
+        err << "The data directory of the game has not been found, use --root.\n";
+        return 2;
+    }
+
+    auto mods = parser.isSet(modsOption) ? parser.value(modsOption).split(',') : AppSettings::GetEnabledMods();
+    mods.removeAll(QString());
+    QStringList searchPaths;
+    for (auto & name : mods)
+    {
+        searchPaths += AppSettings::GetModPath(name);
+    }
+    searchPaths += QFileInfo(root).absoluteFilePath();
+
+    PageRenderer::Options options;
+    options.scale = parser.value(scaleOption).toDouble();
+    options.frames = parser.value(framesOption).toInt();
+    options.fps = parser.value(fpsOption).toInt();
+    options.apng = parser.isSet(apngOption);
+    if (options.scale <= 0 || options.frames < 1 || options.fps < 1 || options.fps > 1000)
+    {
+        err << "Invalid scale, frames or fps.\n";
+        return 2;
+    }
+
+    auto jobs = std::max(parser.value(jobsOption).toInt(), 1);
+
+    if (parser.isSet(workerOption))
+    {
+        // the pages decoded by the other workers already use the other cores
+        QThreadPool::globalInstance()->setMaxThreadCount(std::max(QThread::idealThreadCount() / jobs, 1));
+
+        PageRenderer renderer(searchPaths);
+        auto result = renderer.render(parser.positionalArguments().value(0), parser.value(outputOption), options);
+
+        QJsonObject object {
+            { "ok", result.ok },
+            { "error", result.error },
+            { "warnings", QJsonArray::fromStringList(result.warnings) },
+            { "elements", result.elements },
+            { "events", result.events },
+            { "load", result.loadTime },
+            { "render", result.renderTime },
+            { "write", result.writeTime }
+        };
+
+        QTextStream out(stdout);
+        out << "\n" << QJsonDocument(object).toJson(QJsonDocument::Compact) << "\n";
+        return result.ok ? 0 : 1;
+    }
+
+    // each page goes in its own directory, named after its path in the given directory
+    QVector<BatchRenderer::Job> pages;
+    auto output = QFileInfo(parser.value(outputOption)).absoluteFilePath();
+    for (auto & argument : parser.positionalArguments())
+    {
+        QFileInfo info(argument);
+        if (info.isDir())
+        {
+            QDir directory(argument);
+            QDirIterator it(argument, { "*.hsp" }, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+            {
+                auto page = it.next();
+                auto relative = directory.relativeFilePath(page);
+                relative.chop(QFileInfo(page).suffix().size() + 1);
+                pages.append({ page, output + "/" + relative });
+            }
+        }
+        else if (info.isFile())
+        {
+            pages.append({ argument, output + "/" + info.completeBaseName() });
+        }
+        else
+        {
+            err << QString("'%1' does not exist.\n").arg(argument);
+        }
+    }
+
+    if (pages.isEmpty())
+    {
+        parser.showHelp(2);
+    }
+
+    std::sort(pages.begin(), pages.end(), [](const BatchRenderer::Job & first, const BatchRenderer::Job & second) {
+        return first.page < second.page;
+    });
+
+    jobs = std::min(jobs, pages.size());
+
+    // lists the assets once, the workers read the listings from the manifest.
+    // the manifest is shared with the editor, what only the editor uses is kept
+    AssetIndex::Rebuild(searchPaths);
+    AssetManifest::Save(false);
+
+    QStringList workerArguments {
+        "--worker",
+        "--root", root,
+        "--mods", mods.join(','),
+        "--scale", QString::number(options.scale),
+        "--frames", QString::number(options.frames),
+        "--fps", QString::number(options.fps),
+        "--jobs", QString::number(jobs)
+    };
+    if (options.apng)
+    {
+        workerArguments += "--apng";
+    }
+
+    BatchRenderer renderer(workerArguments, jobs);
+    QObject::connect(&renderer, &BatchRenderer::finished, &a, [&]() {
+        a.exit(renderer.failures() ? 1 : 0);
+    });
+    renderer.start(pages);
+
+    return a.exec();
+}
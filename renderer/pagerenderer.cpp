@@ -0,0 +1,235 @@
+#include "pagerenderer.h"
+#include "page.h"
+#include "pageloader.h"
+#include "apngwriter.h"
+#include "assetindex.h"
+#include "appsettings.h"
+#include "globals.h"
+#include <QApplication>
+#include <QMessageBox>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDir>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QThreadPool>
+
+PageRenderer::PageRenderer(QStringList searchPaths)
+{
+    AssetIndex::Rebuild(searchPaths);
+
+    for (auto path : searchPaths)
+    {
+        fontDatabase.load(path + "/images/fonts");
+    }
+
+    // the events are named like in the editor, whatever their case in the page
+    QFile f(AppSettings::GetFilePath("/misc/events.txt"));
+    if (f.open(QFile::ReadOnly))
+    {
+        for (auto name : QString(f.readAll()).split('\n'))
+        {
+            name = name.trimmed();
+            if (!name.isEmpty())
+            {
+                realEventsNames.append(name);
+            }
+        }
+    }
+
+    qApp->installEventFilter(this);
+}
+
+PageRenderer::~PageRenderer()
+{
+    qApp->removeEventFilter(this);
+}
+
+PageRenderer::Result PageRenderer::render(QString filename, QString outputDirectory, Options options)
+{
+    Result result;
+    warnings.clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly))
+    {
+        result.error = file.errorString();
+        return result;
+    }
+
+    webpage = new Page(&host);
+
+    bool damaged = false;
+    elements = PageLoader::Load(webpage, file.readAll(), realEventsNames, &damaged);
+    if (damaged)
+    {
+        warnings += QString("The page is damaged, only its first %1 elements have been loaded.").arg(elements.size());
+    }
+
+    // the events of the webpage first, then the ones only used by elements
+    auto events = webpage->activeEvents();
+    if (!events.contains(EVENT_DEFAULT))
+    {
+        events.prepend(EVENT_DEFAULT);
+    }
+    for (auto element : elements)
+    {
+        for (auto & name : element->activeEvents())
+        {
+            if (!events.contains(name))
+            {
+                events.append(name);
+            }
+        }
+    }
+
+    result.loadTime = timer.elapsed();
+
+    // the animations only move when the frames are captured
+    AnimationClock::SetManual(true);
+    AnimationClock::SetVisibleRect(QRectF());
+
+    QDir().mkpath(outputDirectory);
+    for (auto name : events)
+    {
+        QElapsedTimer eventTimer;
+        eventTimer.start();
+        setEvent(name);
+        result.renderTime += eventTimer.elapsed();
+
+        name.replace(QRegExp("[/\\\\:*?\"<>|]"), "_");
+        auto path = outputDirectory + "/" + name;
+        if (!capture(path, options, result.renderTime, result.writeTime))
+        {
+            warnings += QString("Unable to write '%1'.").arg(path);
+        }
+    }
+
+    result.ok = true;
+    result.elements = elements.size();
+    result.events = events.size();
+    result.warnings = warnings;
+
+    // the elements are deleted with the scene
+    delete webpage;
+    webpage = nullptr;
+    elements.clear();
+
+    return result;
+}
+
+// the message boxes of the elements and the page would wait for someone to close them
+bool PageRenderer::eventFilter(QObject * watched, QEvent * event)
+{
+    if (event->type() == QEvent::Show)
+    {
+        auto box = qobject_cast<QMessageBox*>(watched);
+        if (box)
+        {
+            if (!warnings.contains(box->text()))
+            {
+                warnings += box->text();
+            }
+            QMetaObject::invokeMethod(box, "reject", Qt::QueuedConnection);
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+// the event shown by something without it, never a new one
+static QString shownEvent(const QStringList & activeEvents, const QString & name)
+{
+    if (activeEvents.contains(name) || activeEvents.isEmpty())
+    {
+        return name;
+    }
+
+    return activeEvents.contains(EVENT_DEFAULT) ? EVENT_DEFAULT : activeEvents.first();
+}
+
+// the elements without this event show their default one, like in the game
+void PageRenderer::setEvent(QString name)
+{
+    webpage->setEvent(shownEvent(webpage->activeEvents(), name));
+    // the editor applies the background when the event is selected
+    webpage->setBackground(webpage->background());
+
+    for (auto element : elements)
+    {
+        element->setEvent(shownEvent(element->activeEvents(), name));
+        element->refresh();
+    }
+
+    // the frames of the animated gifs are recolored on the thread pool,
+    // and given back to them through the event loop.
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+
+    for (auto element : elements)
+    {
+        // the first frame, the clock isn't running
+        element->animate(0, true);
+    }
+}
+
+// the current event, from the state set by setEvent() for the first frame
+bool PageRenderer::capture(QString path, const Options & options, qint64 & renderTime, qint64 & writeTime)
+{
+    QElapsedTimer timer;
+
+    if (options.frames <= 1)
+    {
+        timer.start();
+        auto image = webpage->renderPage(options.scale);
+        renderTime += timer.restart();
+        bool saved = image.save(path + ".png", "PNG");
+        writeTime += timer.elapsed();
+        return saved;
+    }
+
+    QSaveFile file(path + ".png");
+    ApngWriter writer(&file, options.frames, options.fps);
+    if (options.apng && !file.open(QSaveFile::WriteOnly))
+    {
+        return false;
+    }
+    else if (!options.apng)
+    {
+        QDir().mkpath(path);
+    }
+
+    bool saved = true;
+    for (int i = 0; i < options.frames && saved; i++)
+    {
+        timer.start();
+        if (i > 0)
+        {
+            AnimationClock::Step(1.f / options.fps);
+        }
+        auto image = webpage->renderPage(options.scale);
+        renderTime += timer.restart();
+
+        if (options.apng)
+        {
+            saved = writer.writeFrame(image);
+        }
+        else
+        {
+            saved = image.save(QString("%1/%2.png").arg(path).arg(i, 5, 10, QChar('0')), "PNG");
+        }
+        writeTime += timer.elapsed();
+    }
+
+    if (options.apng)
+    {
+        timer.start();
+        saved = writer.finish() && saved && file.commit();
+        writeTime += timer.elapsed();
+    }
+
+    return saved;
+}
@@ -0,0 +1,62 @@
+#ifndef PAGERENDERER_H
+#define PAGERENDERER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QStringList>
+#include "fontdatabase.h"
+#include "animationclock.h"
+
+class Page;
+class PageElement;
+
+// loads a page like the editor does and writes a full-page PNG, or its
+// animation, for each of its events. the message boxes of the elements
+// become warnings.
+class PageRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        qreal scale = 1;
+        // more than one: the animations are captured, stepped 1/fps second at a time
+        int frames = 1;
+        int fps = 60;
+        // a single animated PNG instead of a numbered PNG per frame
+        bool apng = false;
+    };
+
+    struct Result {
+        bool ok = false;
+        QString error;
+        QStringList warnings;
+        int elements = 0;
+        int events = 0;
+        qint64 loadTime = 0;
+        qint64 renderTime = 0;
+        qint64 writeTime = 0;
+    };
+
+    PageRenderer(QStringList searchPaths);
+    ~PageRenderer();
+
+    Result render(QString filename, QString outputDirectory, Options options);
+
+    bool eventFilter(QObject * watched, QEvent * event) override;
+
+private:
+    void setEvent(QString name);
+    bool capture(QString path, const Options & options, qint64 & renderTime, qint64 & writeTime);
+
+    FontDatabase fontDatabase;
+    AnimationClock animationClock;
+    QWidget host;
+    QStringList realEventsNames;
+
+    Page * webpage = nullptr;
+    QVector<PageElement*> elements;
+    QStringList warnings;
+};
+
+#endif // PAGERENDERER_H
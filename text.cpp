@@ -7,13 +7,9 @@
 #include <QBitmap>
 #include <cmath>
 #include <QStyleOptionGraphicsItem>
-#include <QSequentialAnimationGroup>
-#include <QVariantAnimation>
 
 Text::Text()
 {
-    startTimer(16);
-
     colorizeEffect = new QGraphicsColorizeEffect(this);
     colorizeEffect->setColor(Qt::black);
     setGraphicsEffect(colorizeEffect);
@@ -25,8 +21,42 @@ void Text::refresh()
 {
     auto & ev = events[currentEvent];
 
+    resetProgress();
     setHSPosition(ev.xoffset, ev.y);
     setFade(ev.fadeColor, ev.fadeSpeed);
+    renderText(ev.string);
+}
+
+// the animations of an event start over, whatever was animated before
+void Text::resetProgress()
+{
+    auto & evData = events[currentEvent];
+
+    typewriterProgress = 0;
+    evData.typewriterDirection = 1;
+    evData.typewriterTimer = 100;
+    evData.floating = 0;
+    evData.marquee = 0;
+    fadeProgress = 0;
+    textIsDirty = true;
+}
+
+void Text::assetsChanged(const QStringList & changedPaths)
+{
+    for (auto & path : changedPaths)
+    {
+        if (path.contains("/images/fonts"))
+        {
+            // every event gets its atlas back from the font database
+            for (auto & ev : events)
+            {
+                ev.fontAtlas.reset();
+            }
+            fontIsDirty = true;
+            textIsDirty = true;
+            break;
+        }
+    }
 }
 
 void Text::setEvent(QString name)
@@ -123,7 +153,11 @@ void Text::setString(QString str)
     events[currentEvent].string = str.replace("/n", "\n");
     textIsDirty = true;
 
-    renderText(events[currentEvent].string);
+    // the font may not be known yet, rendered by refresh()
+    if (!IsBulkLoading())
+    {
+        renderText(events[currentEvent].string);
+    }
     AppSettings::SetPageDirty();
 }
 
@@ -174,41 +208,9 @@ void Text::setFade(QColor color, int speed)
     evData.fadeColor = color;
     evData.fadeSpeed = speed;
 
-    if (group)
-    {
-        group->deleteLater();
-        group = nullptr;
-    }
-
-    if (speed == 0 || !color.isValid())
-    {
-        setColor(evData.fontColor);
-        AppSettings::SetPageDirty();
-        return;
-    }
-
-    group = new QSequentialAnimationGroup(this);
-    auto fadeIn = new QVariantAnimation;
-    fadeIn->setStartValue(evData.fontColor);
-    fadeIn->setEndValue(color);
-    fadeIn->setDuration(1000 * speed / 60.f / 2);
-    connect(fadeIn, &QVariantAnimation::valueChanged, [&](const QVariant & value) {
-        setColor(value.value<QColor>());
-    });
-
-    auto fadeOut = new QVariantAnimation;
-    fadeOut->setStartValue(color);
-    fadeOut->setEndValue(evData.fontColor);
-    fadeOut->setDuration(1000 * speed / 60.f / 2);
-    connect(fadeOut, &QVariantAnimation::valueChanged, [&](const QVariant & value) {
-        setColor(value.value<QColor>());
-    });
-
-    group->addAnimation(fadeIn);
-    group->addAnimation(fadeOut);
-    group->setLoopCount(-1);
-
-    group->start();
+    // the fade starts again from the font color, stepped by animate()
+    fadeProgress = 0;
+    setColor(evData.fontColor);
     AppSettings::SetPageDirty();
 }
 
@@ -304,11 +306,6 @@ bool Text::fontBold() const
     return events[currentEvent].fontBold;
 }
 
-QMap<QChar, QPixmap> Text::fontChars() const
-{
-    return events[currentEvent].fontChars;
-}
-
 int Text::fontWidth() const
 {
     return events[currentEvent].fontWidth;
@@ -392,17 +389,19 @@ void Text::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWid
     }
 }
 
-void Text::timerEvent(QTimerEvent * event)
+bool Text::animate(float dt, bool visible)
 {
-    Q_UNUSED(event)
     auto & evData = events[currentEvent];
 
+    // the speeds are expressed per 60 Hz tick
+    auto ticks = dt * 60;
+
     switch (evData.animation)
     {
     case Animation::None:
         break;
     case Animation::TypeWriter:
-        evData.typewriterTimer -= evData.animationSpeed;
+        evData.typewriterTimer -= evData.animationSpeed * ticks;
 
         if (evData.typewriterTimer < 0)
         {
@@ -422,19 +421,24 @@ void Text::timerEvent(QTimerEvent * event)
             {
                 evData.typewriterTimer = 100;
             }
-        }
 
-        typewriterProgress = std::clamp(typewriterProgress, 0.0f, float(evData.string.length()));
-        textIsDirty = true;
+            typewriterProgress = std::clamp(typewriterProgress, 0.0f, float(evData.string.length()));
+            textIsDirty = true;
+        }
         break;
     case Animation::Floating:
-        evData.floating += evData.animationSpeed * 0.4;
+        if (visible)
+        {
+            // the bounding rect follows the floating offset
+            prepareGeometryChange();
+        }
+        evData.floating += evData.animationSpeed * 0.4 * ticks;
         break;
     case Animation::Marquee:
     {
-        evData.marquee -= evData.animationSpeed / 10.0;
+        evData.marquee -= evData.animationSpeed / 10.0 * ticks;
 
-        if (evData.marquee < -evData.renderedWidth/2 - renderedTextes[0].width())
+        if (renderedTextes.size() && evData.marquee < -evData.renderedWidth/2 - renderedTextes[0].width())
         {
             evData.marquee = x() + evData.renderedWidth / 2;
         }
@@ -442,9 +446,37 @@ void Text::timerEvent(QTimerEvent * event)
     }
     }
 
+    // from the font color to the fade color and back, speed ticks in all
+    bool fading = evData.fadeSpeed > 0 && evData.fadeColor.isValid();
+    if (fading)
+    {
+        float halfPeriod = evData.fadeSpeed / 60.f / 2;
+        fadeProgress = std::fmod(fadeProgress + dt, halfPeriod * 2);
+    }
+
+    // off-screen, only the animation's progress is kept up to date
+    if (!visible)
+    {
+        return false;
+    }
+
+    if (fading)
+    {
+        float halfPeriod = evData.fadeSpeed / 60.f / 2;
+        float t = fadeProgress / halfPeriod;
+        float k = t <= 1 ? t : 2 - t;
+
+        auto from = evData.fontColor;
+        auto to = evData.fadeColor;
+        colorizeEffect->setColor(QColor(from.red() + (to.red() - from.red()) * k,
+                                        from.green() + (to.green() - from.green()) * k,
+                                        from.blue() + (to.blue() - from.blue()) * k));
+    }
+
+    bool changed = fading || textIsDirty || fontIsDirty || evData.animation == Animation::Floating || evData.animation == Animation::Marquee;
     renderText(evData.string);
 
-    update();
+    return changed;
 }
 
 QVariant Text::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
@@ -462,7 +494,7 @@ QVariant Text::itemChange(QGraphicsItem::GraphicsItemChange change, const QVaria
 
 void Text::renderText(QString string)
 {
-    if (fontIsDirty)
+    if (fontIsDirty || (!events[currentEvent].fontAtlas && !events[currentEvent].fontName.isEmpty()))
     {
         regenerateFont();
     }
@@ -470,7 +502,8 @@ void Text::renderText(QString string)
     if (!textIsDirty) return;
 
     auto & evData = events[currentEvent];
-    auto & font = FontDatabase::GetFont(QString("%1%2%3").arg(evData.fontName).arg(evData.fontSize).arg(evData.fontBold ? 'b' : 'n'));
+    auto fontFullName = QString("%1%2%3").arg(evData.fontName).arg(evData.fontSize).arg(evData.fontBold ? 'b' : 'n');
+    auto & font = FontDatabase::GetFont(fontFullName);
 
     QStringList lines;
 
@@ -515,55 +548,114 @@ void Text::renderText(QString string)
         lines.push_back(string);
     }
 
+    auto previousLines = renderedLines;
+    auto previousTextes = renderedTextes;
+
+    prepareGeometryChange();
     renderedTextes.clear();
+    renderedLines.clear();
     for (auto line : lines)
     {
-        auto newText = QPixmap(evData.fontWidth * line.length(), evData.fontHeight);
-        newText.fill(Qt::transparent);
-
-        QPainter painter;
-        painter.begin(&newText);
-        int xx = 0;
-        int newWidth = 0;
-        for (int yy = 0; auto c : line)
+        QPixmap newText;
+        auto key = fontFullName + '\n' + line;
+        if (auto cached = lineCache.object(key))
         {
-            painter.drawPixmap(xx, yy, evData.fontChars[c.toLatin1()]);
-            newWidth = xx + evData.fontWidth;
-            xx += font.getWidth(c.toLatin1(), evData.fontWidth);
+            newText = *cached;
         }
-        painter.end();
-        if (xx > 0)
+        else
         {
-            renderedTextes.push_back(newText.copy(0, 0, newWidth, evData.fontHeight));
+            // while typing, the same line was rendered a character shorter last time
+            auto index = renderedLines.size();
+            if (index < previousLines.size())
+            {
+                newText = renderLine(line, previousLines.at(index), previousTextes.at(index));
+            }
+            else
+            {
+                newText = renderLine(line, QString(), QPixmap());
+            }
+
+            if (!newText.isNull())
+            {
+                lineCache.insert(key, new QPixmap(newText), newText.width() * newText.height() * 4 / 1024 + 1);
+            }
+        }
+
+        if (!newText.isNull())
+        {
+            renderedTextes.push_back(newText);
+            renderedLines.push_back(line);
         }
     }
 
     textIsDirty = false;
 }
 
-void Text::regenerateFont()
+QPixmap Text::renderLine(const QString & line, const QString & previousLine, const QPixmap & previous)
 {
-    static const QString alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.,;:?!-_~#\"'&()[]|`\\/@°+=*€$$<> ";
-
     auto & evData = events[currentEvent];
+    if (!evData.fontAtlas)
+    {
+        return QPixmap();
+    }
 
-    auto fontFullName = QString("%1%2%3").arg(evData.fontName).arg(evData.fontSize).arg(evData.fontBold ? 'b' : 'n');
-    QPixmap pix = FontDatabase::GetFontAtlas(fontFullName);
-    CHECK_DATA(!pix.isNull(), QString("Unable to load font atlas '%1'.").arg(fontFullName))
-    evData.fontWidth = pix.width() / 8;
-    evData.fontHeight = pix.height() / 12;
+    auto & font = FontDatabase::GetFont(QString("%1%2%3").arg(evData.fontName).arg(evData.fontSize).arg(evData.fontBold ? 'b' : 'n'));
 
-    for (int xx = 0, yy = 0; auto c : alphabet)
+    auto newText = QPixmap(evData.fontWidth * line.length(), evData.fontHeight);
+    newText.fill(Qt::transparent);
+
+    QPainter painter;
+    painter.begin(&newText);
+    int xx = 0;
+    int newWidth = 0;
+    int start = 0;
+
+    // only the glyphs after the already rendered prefix are drawn
+    if (!previous.isNull() && line.startsWith(previousLine))
     {
-        evData.fontChars[c] = pix.copy(xx * evData.fontWidth, yy * evData.fontHeight, evData.fontWidth, evData.fontHeight);
+        painter.drawPixmap(0, 0, previous);
+        for (auto c : previousLine)
+        {
+            xx += font.getWidth(c.toLatin1(), evData.fontWidth);
+        }
+        newWidth = previous.width();
+        start = previousLine.length();
+    }
 
-        xx++;
-        if (xx >= 8)
+    for (int yy = 0; auto c : line.mid(start))
+    {
+        auto glyph = evData.fontAtlas->glyphRect(c.toLatin1());
+        if (glyph.isValid())
         {
-            yy++;
-            xx = 0;
+            painter.drawPixmap(xx, yy, evData.fontAtlas->pixmap, glyph.x(), glyph.y(), glyph.width(), glyph.height());
         }
+        newWidth = xx + evData.fontWidth;
+        xx += font.getWidth(c.toLatin1(), evData.fontWidth);
     }
+    painter.end();
+
+    if (xx <= 0)
+    {
+        return QPixmap();
+    }
+
+    return newText.copy(0, 0, newWidth, evData.fontHeight);
+}
+
+void Text::ClearLineCache()
+{
+    lineCache.clear();
+}
+
+void Text::regenerateFont()
+{
+    auto & evData = events[currentEvent];
+
+    auto fontFullName = QString("%1%2%3").arg(evData.fontName).arg(evData.fontSize).arg(evData.fontBold ? 'b' : 'n');
+    evData.fontAtlas = FontDatabase::AcquireFontAtlas(fontFullName);
+    CHECK_DATA(!evData.fontAtlas->pixmap.isNull(), QString("Unable to load font atlas '%1'.").arg(fontFullName))
+    evData.fontWidth = evData.fontAtlas->glyphWidth;
+    evData.fontHeight = evData.fontAtlas->glyphHeight;
 
     textIsDirty = true;
     fontIsDirty = false;
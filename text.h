@@ -3,7 +3,9 @@
 
 #include "pageelement.h"
 #include "globals.h"
+#include "fontdatabase.h"
 #include <QMap>
+#include <QCache>
 #include <QPixmap>
 #include <QGraphicsColorizeEffect>
 #include <QGraphicsItem>
@@ -15,7 +17,6 @@ enum class Animation {
     Marquee
 };
 
-class QSequentialAnimationGroup;
 class Text : public PageElement, public QGraphicsItem
 {
     Q_OBJECT
@@ -25,6 +26,8 @@ public:
     Text();
     ElementType elementType() const override { return ElementType::Text; }
     void refresh() override;
+    void assetsChanged(const QStringList & changedPaths) override;
+    bool animate(float dt, bool visible) override;
 
     void setEvent(QString name) override;
     void clearEvent(QString name) override;
@@ -60,23 +63,25 @@ public:
     QString fontName() const;
     int fontSize() const;
     bool fontBold() const;
-    QMap<QChar, QPixmap> fontChars() const;
     int fontWidth() const;
     int fontHeight() const;
     QColor fadeColor() const;
     int fadeSpeed() const;
     bool noContent() const;
 
+    static void ClearLineCache();
+
     QRectF boundingRect() const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
 protected:
-    void timerEvent(QTimerEvent * event) override;
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
 private:
     void renderText(QString string);
+    QPixmap renderLine(const QString & line, const QString & previousLine, const QPixmap & previous);
     void regenerateFont();
+    void resetProgress();
 
     friend class MainWindow;
     friend class PageSettings;
@@ -98,7 +103,7 @@ private:
         QString fontName;
         int fontSize;
         bool fontBold;
-        QMap<QChar, QPixmap> fontChars;
+        QSharedPointer<const FontDatabase::FontAtlas> fontAtlas;
         int fontWidth = 0;
         int fontHeight = 0;
         QColor fadeColor = Qt::black;
@@ -109,11 +114,15 @@ private:
     QMap<QString, EventData> events;
 
     QVector<QPixmap> renderedTextes;
+    QStringList renderedLines;
     float typewriterProgress = 0;
+    float fadeProgress = 0;
     bool textIsDirty = true;
     bool fontIsDirty = true;
-    QSequentialAnimationGroup * group = nullptr;
     QGraphicsColorizeEffect * colorizeEffect = nullptr;
+
+    // rendered lines, shared by all the texts using the same font (cost in KiB)
+    static inline QCache<QString, QPixmap> lineCache{8 * 1024};
 };
 
 #endif // TEXT_H
@@ -0,0 +1,161 @@
+#include "undostack.h"
+
+// edits closer than this (typing, spin boxes, dragging) are a single command
+constexpr qint64 COALESCE_INTERVAL = 1000;
+
+static qint64 stringSize(const QString & string)
+{
+    return sizeof(QString) + string.size() * sizeof(QChar);
+}
+
+qint64 UndoStack::Command::size() const
+{
+    qint64 bytes = sizeof(Command) + stringSize(event);
+
+    for (auto & change : changes)
+    {
+        bytes += sizeof(Change) + stringSize(change.before) + stringSize(change.after);
+    }
+
+    bytes += stringSize(element.type) + stringSize(element.name);
+    for (auto & row : element.rows)
+    {
+        bytes += sizeof(QStringList);
+        for (auto & value : row)
+        {
+            bytes += stringSize(value);
+        }
+    }
+
+    return bytes;
+}
+
+UndoStack::UndoStack()
+{
+    sinceLastPush.start();
+}
+
+void UndoStack::setBudget(qint64 bytes)
+{
+    maxBytes = bytes;
+    trim();
+    emit changed();
+}
+
+qint64 UndoStack::budget() const
+{
+    return maxBytes;
+}
+
+qint64 UndoStack::usedBytes() const
+{
+    return used;
+}
+
+void UndoStack::push(Command command)
+{
+    for (auto & redone : undone)
+    {
+        used -= redone.size();
+    }
+    undone.clear();
+
+    bool coalesce = false;
+    if (mergeable && !done.empty() && sinceLastPush.elapsed() < COALESCE_INTERVAL)
+    {
+        auto & last = done.back();
+        coalesce = (command.type == Command::Type::Property || command.type == Command::Type::Move)
+                && last.type == command.type && last.id == command.id && last.event == command.event
+                && last.changes.size() == command.changes.size();
+
+        for (int i = 0; coalesce && i < command.changes.size(); i++)
+        {
+            coalesce = last.changes[i].column == command.changes[i].column;
+        }
+    }
+    sinceLastPush.restart();
+    mergeable = true;
+
+    if (coalesce)
+    {
+        // keeps the first values, and the last ones
+        auto & last = done.back();
+        used -= last.size();
+        for (int i = 0; i < command.changes.size(); i++)
+        {
+            last.changes[i].after = command.changes[i].after;
+        }
+        used += last.size();
+    }
+    else
+    {
+        used += command.size();
+        done.push_back(command);
+    }
+
+    trim();
+    emit changed();
+}
+
+void UndoStack::clear()
+{
+    done.clear();
+    undone.clear();
+    used = 0;
+    mergeable = false;
+    emit changed();
+}
+
+bool UndoStack::canUndo() const
+{
+    return !done.empty();
+}
+
+bool UndoStack::canRedo() const
+{
+    return !undone.empty();
+}
+
+UndoStack::Command UndoStack::undo()
+{
+    auto command = done.back();
+    done.pop_back();
+    undone.push_back(command);
+
+    // the next edit isn't merged into the undone command
+    mergeable = false;
+
+    emit changed();
+    return command;
+}
+
+UndoStack::Command UndoStack::redo()
+{
+    auto command = undone.back();
+    undone.pop_back();
+    done.push_back(command);
+
+    mergeable = false;
+
+    emit changed();
+    return command;
+}
+
+// the oldest commands that can be undone go first, then the farthest
+// ones that can be redone, but the last command is always kept.
+void UndoStack::trim()
+{
+    while (used > maxBytes && done.size() + undone.size() > 1)
+    {
+        if (!done.empty())
+        {
+            used -= done.front().size();
+            done.pop_front();
+        }
+        else
+        {
+            used -= undone.front().size();
+            undone.pop_front();
+        }
+    }
+}
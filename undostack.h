@@ -0,0 +1,74 @@
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <deque>
+#include "hspwriter.h"
+
+// the modifications of the page, undone and redone one command at a time.
+// a command only keeps what it changed, and the oldest commands are
+// forgotten once they take more than the byte budget.
+class UndoStack : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Change {
+        int column = 0;
+        QString before;
+        QString after;
+    };
+
+    struct Command {
+        enum class Type {
+            Property,
+            Move,
+            Create,
+            Delete
+        };
+
+        Type type = Type::Property;
+        // -1 for the webpage
+        int id = -1;
+        // Property and Move: the columns of one event
+        QString event;
+        QVector<Change> changes;
+        // Create and Delete: the whole element, and its row in the elements list
+        HspWriter::Element element;
+        int row = -1;
+
+        qint64 size() const;
+    };
+
+    UndoStack();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 usedBytes() const;
+
+    // merged into the previous command when it changes the same
+    // columns of the same event shortly after it
+    void push(Command command);
+    void clear();
+
+    bool canUndo() const;
+    bool canRedo() const;
+    Command undo();
+    Command redo();
+
+signals:
+    void changed();
+
+private:
+    void trim();
+
+    std::deque<Command> done;
+    std::deque<Command> undone;
+    qint64 used = 0;
+    qint64 maxBytes = 0;
+    QElapsedTimer sinceLastPush;
+    bool mergeable = false;
+};
+
+#endif // UNDOSTACK_H
@@ -1,4 +1,5 @@
 #include "utils.h"
+#include <array>
 #include <cmath>
 
 using std::min, std::max;
@@ -107,25 +108,305 @@ static Vec3 hsl_to_rgb(Vec3 hsl)
     return rgb;
 }
 
-QPixmap Utils::ChangeHSL(QPixmap pix, float huerotate, float satadjust, float lumadjust)
+// float(c / 255.0), the value QColor::redF() & co. end up as
+static const auto unit_table = [] {
+    std::array<double, 256> table;
+    for (int c = 0; c < 256; c++)
+    {
+        table[c] = float(c / 255.0);
+    }
+    return table;
+}();
+
+struct HSLParams {
+    float hue = 0;
+    float sat = 1;
+    float lum = 0; // lumadjust - 1
+};
+
+// scalar reference, also used for the tail of each scanline
+static QRgb recolor_pixel(QRgb pixel, const HSLParams & params)
 {
-    auto image = pix.toImage();
+    int alpha = qAlpha(pixel);
+    if (alpha == 0) return pixel;
+
+    float alphaF = unit_table[alpha];
+    Vec3 front = { float(unit_table[qRed(pixel)]), float(unit_table[qGreen(pixel)]), float(unit_table[qBlue(pixel)]) };
+    Vec3 rgb = rgb_to_hsl(front) + Vec3 { params.hue, 0, params.lum * alphaF };
+    rgb.y *= params.sat;
+    rgb = hsl_to_rgb(rgb);
+
+    return qRgba(int(rgb.x * 255), int(rgb.y * 255), int(rgb.z * 255), alpha);
+}
+
+static void recolor_scalar(QRgb * line, int width, const HSLParams & params)
+{
+    for (int x = 0; x < width; x++)
+    {
+        line[x] = recolor_pixel(line[x], params);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HSL_SIMD 1
+
+// The vectorised kernel mirrors the scalar functions above step by step.
+// Those mix float variables with double literals, so the lanes hold doubles
+// and every place where the scalar code stores into a float is rounded
+// through a float vector (rf). This keeps the output bit-identical.
+typedef double V2d __attribute__((vector_size(16)));
+typedef float V2f __attribute__((vector_size(8)));
+typedef int V2i __attribute__((vector_size(8)));
+
+typedef double V4d __attribute__((vector_size(32)));
+typedef float V4f __attribute__((vector_size(16)));
+typedef int V4i __attribute__((vector_size(16)));
+
+template<int N> struct Lanes;
+template<> struct Lanes<2> { using D = V2d; using F = V2f; using I = V2i; };
+template<> struct Lanes<4> { using D = V4d; using F = V4f; using I = V4i; };
+
+template<int N>
+static inline __attribute__((always_inline)) void recolor_lanes(QRgb * line, const HSLParams & params)
+{
+    using D = typename Lanes<N>::D;
+    using F = typename Lanes<N>::F;
+    using I = typename Lanes<N>::I;
+
+    // round to float, as when the scalar code assigns to a float variable
+#define rf(v) __builtin_convertvector(__builtin_convertvector((v), F), D)
+
+    D r, g, b, alphaF;
+    for (int i = 0; i < N; i++)
+    {
+        r[i] = unit_table[qRed(line[i])];
+        g[i] = unit_table[qGreen(line[i])];
+        b[i] = unit_table[qBlue(line[i])];
+        alphaF[i] = unit_table[qAlpha(line[i])];
+    }
+
+    // rgb_to_hsl
+    auto rgMin = g < r ? g : r;
+    auto fmin = b < rgMin ? b : rgMin;
+    auto rgMax = r < g ? g : r;
+    auto fmax = rgMax < b ? b : rgMax;
+    auto delta = rf(fmax - fmin);
+    auto grey = delta == 0.0;
 
-    for (int y = 0; y < pix.height(); y++)
+    D l = rf(rf(fmax + fmin) / 2.0);
+    D s = l < 0.5 ? rf(delta / rf(fmax + fmin)) : rf(delta / (2.0 - fmax - fmin));
+
+    auto dR = rf((rf(fmax - r) / 6.0 + delta / 2.0) / delta);
+    auto dG = rf((rf(fmax - g) / 6.0 + delta / 2.0) / delta);
+    auto dB = rf((rf(fmax - b) / 6.0 + delta / 2.0) / delta);
+
+    D h = r == fmax ? rf(dB - dG) : (g == fmax ? rf((1.0 / 3.0) + dR - dB) : rf((2.0 / 3.0) + dG - dR));
+    h = h < 0.0 ? rf(h + 1.0) : (h > 1.0 ? rf(h - 1.0) : h);
+
+    D zero = {};
+    h = grey ? zero : h;
+    s = grey ? zero : s;
+
+    // adjustments
+    h = rf(h + params.hue);
+    l = rf(l + rf(params.lum * alphaF));
+    s = rf(s * params.sat);
+
+    // hsl_to_rgb
+    auto f2 = l < 0.5 ? rf(l * (1.0 + s)) : rf(rf(l + s) - rf(s * l));
+    auto f1 = rf(2.0 * l - f2);
+
+    auto achromatic = s == 0.0;
+    D hues[3] = { rf(h + (1.0 / 3.0)), h, rf(h - (1.0 / 3.0)) };
+    D out[3];
+    for (int c = 0; c < 3; c++)
+    {
+        // hue_to_rgb
+        auto hue = hues[c];
+        hue = hue < 0.0 ? rf(hue + 1.0) : (hue > 1.0 ? rf(hue - 1.0) : hue);
+
+        auto d = rf(f2 - f1);
+        auto rising = rf(f1 + d * 6.0 * hue);
+        auto falling = rf(f1 + d * ((2.0 / 3.0) - hue) * 6.0);
+
+        out[c] = (6.0 * hue) < 1.0 ? rising : ((2.0 * hue) < 1.0 ? f2 : ((3.0 * hue) < 2.0 ? falling : f1));
+        out[c] = achromatic ? l : out[c];
+    }
+    auto outR = out[0], outG = out[1], outB = out[2];
+
+    D one = zero + 1.0;
+    outR = outR < 0.0 ? zero : (outR > 1.0 ? one : outR);
+    outG = outG < 0.0 ? zero : (outG > 1.0 ? one : outG);
+    outB = outB < 0.0 ? zero : (outB > 1.0 ? one : outB);
+
+    auto ir = __builtin_convertvector(rf(outR * 255.0), I);
+    auto ig = __builtin_convertvector(rf(outG * 255.0), I);
+    auto ib = __builtin_convertvector(rf(outB * 255.0), I);
+
+    for (int i = 0; i < N; i++)
     {
-        for (int x = 0; x < pix.width(); x++)
+        if (qAlpha(line[i]) > 0)
         {
-            auto color = image.pixelColor(x, y);
-            if (color.alphaF() > 0)
+            line[i] = qRgba(ir[i], ig[i], ib[i], qAlpha(line[i]));
+        }
+    }
+#undef rf
+}
+
+static void recolor_sse2(QRgb * line, int width, const HSLParams & params)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        recolor_lanes<2>(line + x, params);
+        recolor_lanes<2>(line + x + 2, params);
+    }
+    recolor_scalar(line + x, width - x, params);
+}
+
+__attribute__((target("avx2")))
+static void recolor_avx2(QRgb * line, int width, const HSLParams & params)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        recolor_lanes<4>(line + x, params);
+        recolor_lanes<4>(line + x + 4, params);
+    }
+    recolor_scalar(line + x, width - x, params);
+}
+#endif
+
+using RecolorKernel = void (*)(QRgb *, int, const HSLParams &);
+
+static RecolorKernel select_kernel()
+{
+#ifdef HSL_SIMD
+    if (qEnvironmentVariableIsSet("PAGEBUILDER_NO_SIMD"))
+        return recolor_scalar;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return recolor_avx2;
+
+    return recolor_sse2;
+#else
+    return recolor_scalar;
+#endif
+}
+
+// Hypnospace art only uses a handful of colors, so it's cheaper to
+// recolor each distinct color once and remap the pixels through a table.
+class PaletteMap
+{
+public:
+    static constexpr int MaxColors = 256;
+
+    bool build(const QImage & image)
+    {
+        used.fill(false);
+        colors.clear();
+
+        for (int y = 0; y < image.height(); y++)
+        {
+            auto line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+            QRgb last = ~line[0];
+            for (int x = 0; x < image.width(); x++)
             {
-                Vec3 front = { (float)color.redF(), (float)color.greenF(), (float)color.blueF() };
-                Vec3 rgb = rgb_to_hsl(front) + Vec3 { huerotate, 0, (lumadjust - 1.0f) * (float)color.alphaF() };
-                rgb.y *= satadjust;
-                rgb = hsl_to_rgb(rgb);
-                image.setPixelColor(x, y, QColor(rgb.x * 255, rgb.y * 255, rgb.z * 255, color.alpha()));
+                if (line[x] == last) continue;
+                last = line[x];
+
+                auto slot = find(last);
+                if (!used[slot])
+                {
+                    if (colors.size() == MaxColors)
+                    {
+                        return false;
+                    }
+
+                    used[slot] = true;
+                    keys[slot] = last;
+                    colors.push_back(last);
+                }
             }
         }
+
+        return true;
+    }
+
+    void recolor(QImage & image, RecolorKernel kernel, const HSLParams & params)
+    {
+        auto recolored = colors;
+        kernel(recolored.data(), recolored.size(), params);
+        for (int i = 0; i < colors.size(); i++)
+        {
+            values[find(colors[i])] = recolored[i];
+        }
+
+        for (int y = 0; y < image.height(); y++)
+        {
+            auto line = reinterpret_cast<QRgb*>(image.scanLine(y));
+            QRgb lastIn = ~line[0];
+            QRgb lastOut = 0;
+            for (int x = 0; x < image.width(); x++)
+            {
+                if (line[x] != lastIn)
+                {
+                    lastIn = line[x];
+                    lastOut = values[find(lastIn)];
+                }
+                line[x] = lastOut;
+            }
+        }
+    }
+
+private:
+    static constexpr int Capacity = 1024; // power of two, well above MaxColors
+
+    int find(QRgb color) const
+    {
+        int slot = (color * 2654435761u) >> 22;
+        while (used[slot] && keys[slot] != color)
+        {
+            slot = (slot + 1) & (Capacity - 1);
+        }
+        return slot;
+    }
+
+    std::array<bool, Capacity> used;
+    std::array<QRgb, Capacity> keys;
+    std::array<QRgb, Capacity> values;
+    QVector<QRgb> colors;
+};
+
+QPixmap Utils::ChangeHSL(QPixmap pix, float huerotate, float satadjust, float lumadjust)
+{
+    return QPixmap::fromImage(ChangeHSL(pix.toImage(), huerotate, satadjust, lumadjust));
+}
+
+// safe to call from worker threads, unlike the QPixmap overload
+QImage Utils::ChangeHSL(QImage image, float huerotate, float satadjust, float lumadjust)
+{
+    static const RecolorKernel kernel = select_kernel();
+
+    image = image.convertToFormat(QImage::Format_ARGB32);
+    HSLParams params { huerotate, satadjust, lumadjust - 1.0f };
+
+    if (image.width() > 0)
+    {
+        PaletteMap palette;
+        if (palette.build(image))
+        {
+            palette.recolor(image, kernel, params);
+            return image;
+        }
+    }
+
+    // too many colors, recolor every pixel
+    for (int y = 0; y < image.height(); y++)
+    {
+        kernel(reinterpret_cast<QRgb*>(image.scanLine(y)), image.width(), params);
     }
 
-    return QPixmap::fromImage(image);
+    return image;
 }
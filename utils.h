@@ -2,11 +2,13 @@
 #define UTILS_H
 
 #include <QPixmap>
+#include <QImage>
 
 class Utils
 {
 public:
     static QPixmap ChangeHSL(QPixmap pix, float huerotate, float satadjust, float lumadjust);
+    static QImage ChangeHSL(QImage image, float huerotate, float satadjust, float lumadjust);
 };
 
 #endif // UTILS_H